@@ -0,0 +1,273 @@
+//
+//  Ripe
+//
+//  Copyright 2017-present Amrayn Web Services
+//
+//  https://muflihun.com
+//  https://amrayn.com
+//  https://github.com/amrayn/ripe
+//
+//  Author: @abumusamq
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "include/Ripe.h"
+
+// Run with --benchmark_format=json (or --benchmark_out=<file> --benchmark_out_format=json)
+// for machine-readable results
+
+namespace {
+
+const std::string AES_KEY = "B1C8BFB9DA2D4FB054FE73047AE700BC";
+const std::string AES_IV = "67e56fee50e22a8c2ba05c0fb2932bfa";
+
+// Deterministic text that is compressible (like real payloads) but not trivially so
+std::string payload(std::size_t size)
+{
+    static const char* WORDS[] = { "ripe ", "cipher ", "packet ", "data ", "key ", "zlib ", "base64 ", "block " };
+    std::string result;
+    result.reserve(size + 8);
+    std::uint32_t seed = 2463534242U;
+    while (result.size() < size) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        result.append(WORDS[seed % 8]);
+        if (seed % 5 == 0) {
+            result.push_back(static_cast<char>('0' + seed % 10));
+        }
+    }
+    result.resize(size);
+    return result;
+}
+
+void setBytesProcessed(benchmark::State& state, std::size_t bytes)
+{
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes));
+}
+
+// RSA keys are generated once per length and shared by all RSA benchmarks
+struct RSAKeys
+{
+    std::unique_ptr<Ripe::RSAPublicKeyHandle> publicKey;
+    std::unique_ptr<Ripe::RSAPrivateKeyHandle> privateKey;
+};
+
+const RSAKeys& rsaKeys(unsigned int length)
+{
+    static std::map<unsigned int, RSAKeys> keys;
+    RSAKeys& entry = keys[length];
+    if (!entry.publicKey) {
+        const Ripe::KeyPair pair = Ripe::generateRSAKeyPair(length);
+        entry.publicKey.reset(new Ripe::RSAPublicKeyHandle(pair.publicKey));
+        entry.privateKey.reset(new Ripe::RSAPrivateKeyHandle(pair.privateKey));
+    }
+    return entry;
+}
+
+const std::string RSA_DATA = payload(32);
+
+} // namespace
+
+static void BM_EncryptAES(benchmark::State& state)
+{
+    const std::string data = payload(static_cast<std::size_t>(state.range(0)));
+    const std::string key = Ripe::hexToString(AES_KEY);
+    Ripe::AESIV iv;
+    Ripe::parseIV(AES_IV, iv);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::encryptAES(data, reinterpret_cast<const RipeByte*>(key.data()), key.size(), iv));
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_EncryptAES)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_DecryptAES(benchmark::State& state)
+{
+    const std::string key = Ripe::hexToString(AES_KEY);
+    Ripe::AESIV iv;
+    Ripe::parseIV(AES_IV, iv);
+    const std::string cipher = Ripe::encryptAES(payload(static_cast<std::size_t>(state.range(0))),
+                                                reinterpret_cast<const RipeByte*>(key.data()), key.size(), iv);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::decryptAES(cipher, reinterpret_cast<const RipeByte*>(key.data()), key.size(), iv));
+    }
+    setBytesProcessed(state, static_cast<std::size_t>(state.range(0)));
+}
+BENCHMARK(BM_DecryptAES)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_AESContextEncrypt(benchmark::State& state)
+{
+    // Key schedule is computed once instead of on every call
+    const std::string data = payload(static_cast<std::size_t>(state.range(0)));
+    Ripe::AESContext context(AES_KEY);
+    Ripe::AESIV iv;
+    Ripe::parseIV(AES_IV, iv);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(context.encrypt(data, iv));
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_AESContextEncrypt)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_PrepareData(benchmark::State& state)
+{
+    const std::string data = payload(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::prepareData(data, AES_KEY, "client-id"));
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_PrepareData)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+static void BM_PrepareDataContext(benchmark::State& state)
+{
+    const std::string data = payload(static_cast<std::size_t>(state.range(0)));
+    Ripe::AESContext context(AES_KEY);
+    std::string output;
+    for (auto _ : state) {
+        output.clear();
+        Ripe::prepareData(data, context, output, "client-id");
+        benchmark::DoNotOptimize(output.data());
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_PrepareDataContext)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+static void BM_Base64Encode(benchmark::State& state)
+{
+    const std::string data = payload(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::base64Encode(data));
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_Base64Encode)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_Base64Decode(benchmark::State& state)
+{
+    const std::string encoded = Ripe::base64Encode(payload(static_cast<std::size_t>(state.range(0))));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::base64Decode(encoded));
+    }
+    setBytesProcessed(state, encoded.size());
+}
+BENCHMARK(BM_Base64Decode)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_HexEncode(benchmark::State& state)
+{
+    const std::string data = payload(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::stringToHex(data));
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_HexEncode)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_HexDecode(benchmark::State& state)
+{
+    const std::string hex = Ripe::stringToHex(payload(static_cast<std::size_t>(state.range(0))));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::hexToString(hex));
+    }
+    setBytesProcessed(state, hex.size());
+}
+BENCHMARK(BM_HexDecode)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_CompressString(benchmark::State& state)
+{
+    // Arguments: compression level, data size
+    const std::string data = payload(static_cast<std::size_t>(state.range(1)));
+    const Ripe::ZlibOptions options(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::compressString(data, options));
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_CompressString)->ArgsProduct({ { 1, 6, 9 }, { 4 << 10, 1 << 20 } });
+
+static void BM_DecompressString(benchmark::State& state)
+{
+    const std::string compressed = Ripe::compressString(payload(static_cast<std::size_t>(state.range(0))));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::decompressString(compressed));
+    }
+    setBytesProcessed(state, static_cast<std::size_t>(state.range(0)));
+}
+BENCHMARK(BM_DecompressString)->Arg(4 << 10)->Arg(1 << 20);
+
+static void BM_SHA256(benchmark::State& state)
+{
+    const std::string data = payload(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::sha256Hash(data));
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_SHA256)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_SHA512(benchmark::State& state)
+{
+    const std::string data = payload(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::sha512Hash(data));
+    }
+    setBytesProcessed(state, data.size());
+}
+BENCHMARK(BM_SHA512)->RangeMultiplier(16)->Range(64, 16 << 20);
+
+static void BM_RSAEncrypt(benchmark::State& state)
+{
+    const RSAKeys& keys = rsaKeys(static_cast<unsigned int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::encryptRSA(RSA_DATA, *keys.publicKey));
+    }
+}
+BENCHMARK(BM_RSAEncrypt)->Arg(1024)->Arg(2048)->Arg(4096);
+
+static void BM_RSADecrypt(benchmark::State& state)
+{
+    const RSAKeys& keys = rsaKeys(static_cast<unsigned int>(state.range(0)));
+    const std::string cipher = Ripe::encryptRSA(RSA_DATA, *keys.publicKey);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::decryptRSA(cipher, *keys.privateKey));
+    }
+}
+BENCHMARK(BM_RSADecrypt)->Arg(1024)->Arg(2048)->Arg(4096);
+
+static void BM_RSASign(benchmark::State& state)
+{
+    const RSAKeys& keys = rsaKeys(static_cast<unsigned int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::signRSA(RSA_DATA, *keys.privateKey));
+    }
+}
+BENCHMARK(BM_RSASign)->Arg(1024)->Arg(2048)->Arg(4096);
+
+static void BM_RSAVerify(benchmark::State& state)
+{
+    const RSAKeys& keys = rsaKeys(static_cast<unsigned int>(state.range(0)));
+    const std::string signature = Ripe::signRSA(RSA_DATA, *keys.privateKey);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Ripe::verifyRSA(RSA_DATA, signature, *keys.publicKey));
+    }
+}
+BENCHMARK(BM_RSAVerify)->Arg(1024)->Arg(2048)->Arg(4096);
+
+BENCHMARK_MAIN();
@@ -28,6 +28,13 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <memory>
 
 typedef unsigned char RipeByte;
 
@@ -75,6 +82,16 @@ public:
     ///
     static const int AES_BLOCK_SIZE;
 
+    ///
+    /// \brief Size of initialization vector (nonce) for AES-GCM
+    ///
+    static const int AES_GCM_IV_SIZE;
+
+    ///
+    /// \brief Size of authentication tag appended to AES-GCM cipher
+    ///
+    static const int AES_GCM_TAG_SIZE;
+
     ///
     /// \brief Possible base64 characters
     ///
@@ -91,7 +108,45 @@ public:
     static const int ZLIB_BUFFER_SIZE;
 
     ///
-    /// \brief RSA Key pair
+    /// \brief Size of chunks read from input streams when processing streams / files
+    ///
+    static const std::size_t STREAM_CHUNK_SIZE;
+
+    ///
+    /// \brief Default size of plain data in each segment of chunked AES cipher
+    /// \see encryptAESChunked(const std::string&, const RipeByte*, std::size_t, AESMode, unsigned int, std::size_t)
+    ///
+    static const std::size_t AES_SEGMENT_SIZE;
+
+    ///
+    /// \brief Size of fixed header at start of RSA envelope
+    /// \see encryptRSAEnvelope(const std::string&, const RSAPublicKeyHandle&)
+    ///
+    static const std::size_t RSA_ENVELOPE_HEADER_SIZE;
+
+    ///
+    /// \brief Version of binary packet format
+    /// \see prepareBinaryData(const std::string&, AESContext&, std::string&, const std::string&, AESMode, const RipeByte*)
+    ///
+    static const RipeByte BINARY_PACKET_VERSION;
+
+    ///
+    /// \brief Fixed-size AES initialization vector (AES_BLOCK_SIZE bytes)
+    /// \see parseIV(const std::string&, AESIV&)
+    ///
+    typedef std::array<RipeByte, 16> AESIV;
+
+    ///
+    /// \brief AES modes of operation
+    ///
+    enum AESMode {
+        AES_CBC = 0,
+        AES_GCM = 1,
+        AES_CTR = 2
+    };
+
+    ///
+    /// \brief RSA or Ed25519 Key pair
     ///
     struct KeyPair {
         ///
@@ -129,6 +184,36 @@ public:
     ///
     static std::string decryptAES(const std::string& data, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv);
 
+    ///
+    /// \brief Encrypts data with symmetric key of size = keySize with specified initialization vector
+    ///
+    static std::string encryptAES(const std::string& data, const RipeByte* key, std::size_t keySize, const AESIV& iv);
+
+    ///
+    /// \brief Decrypts data with specified key and initialization vector
+    ///
+    static std::string decryptAES(const std::string& data, const RipeByte* key, std::size_t keySize, const AESIV& iv);
+
+    ///
+    /// \brief Encrypts n bytes of input in to caller-provided output buffer
+    /// \param outCap Capacity of output, must be at least expectedAESCipherLength(n)
+    /// \param iv Initialization vector of AES_BLOCK_SIZE bytes
+    /// \return Number of bytes written to output
+    /// \see AESContext::encrypt(const RipeByte*, std::size_t, RipeByte*, std::size_t, const RipeByte*)
+    ///
+    static std::size_t encryptAES(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap,
+                                  const RipeByte* key, std::size_t keySize, const RipeByte* iv);
+
+    ///
+    /// \brief Decrypts n bytes of input in to caller-provided output buffer
+    /// \param outCap Capacity of output, must be at least n
+    /// \param iv Initialization vector of AES_BLOCK_SIZE bytes
+    /// \return Number of bytes written to output
+    /// \see AESContext::decrypt(const RipeByte*, std::size_t, RipeByte*, std::size_t, const RipeByte*)
+    ///
+    static std::size_t decryptAES(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap,
+                                  const RipeByte* key, std::size_t keySize, const RipeByte* iv);
+
     ///
     /// \brief Generate random AES key
     /// \param length Length of key, must be 16, 24 or 32
@@ -136,6 +221,375 @@ public:
     ///
     static std::string generateNewKey(int length);
 
+    ///
+    /// \brief Generator that fills output with size cryptographically secure random bytes.
+    /// It is called from any thread so it must be thread-safe.
+    ///
+    typedef std::function<void(RipeByte* output, std::size_t size)> RandomGenerator;
+
+    ///
+    /// \brief Default number of random bytes each thread generates before it is reseeded
+    /// \see setRandomReseedInterval(std::size_t)
+    ///
+    static const std::size_t RANDOM_RESEED_INTERVAL;
+
+    ///
+    /// \brief Replaces random generator used for keys, IVs, RSA padding, blinding and validation.
+    /// Passing empty generator restores default one.
+    ///
+    /// Default generator keeps one Crypto++ AutoSeededRandomPool per thread (seeded from OS once) that is reseeded
+    /// after every RANDOM_RESEED_INTERVAL bytes it generates and in child process after fork().
+    ///
+    static void setRandomGenerator(const RandomGenerator& generator);
+
+    ///
+    /// \brief Changes number of bytes default generator produces before reseeding, 0 reseeds on every request
+    ///
+    static void setRandomReseedInterval(std::size_t bytes);
+
+    ///
+    /// \brief Fills output with size random bytes from current random generator
+    ///
+    static void generateRandom(RipeByte* output, std::size_t size);
+
+    ///
+    /// \brief Allocator for scratch buffers. allocate(size) returns at least size bytes (or throws) and
+    /// deallocate(pointer, size) receives same size back. It is called from any thread so it must be thread-safe.
+    ///
+    struct ScratchAllocator
+    {
+        std::function<RipeByte*(std::size_t size)> allocate;
+        std::function<void(RipeByte* pointer, std::size_t size)> deallocate;
+    };
+
+    ///
+    /// \brief Default number of bytes each thread keeps in its scratch pool for reuse
+    /// \see setScratchPoolLimit(std::size_t)
+    ///
+    static const std::size_t SCRATCH_POOL_LIMIT;
+
+    ///
+    /// \brief Replaces allocator that scratch pools get new buffers from. Passing allocator without
+    /// allocate or deallocate restores default one (operator new[]).
+    ///
+    /// Buffers pooled before the change are returned to allocator they came from.
+    ///
+    static void setScratchAllocator(const ScratchAllocator& allocator);
+
+    ///
+    /// \brief Changes number of bytes each thread keeps pooled, 0 disables pooling
+    ///
+    static void setScratchPoolLimit(std::size_t bytes);
+
+    ///
+    /// \brief Frees buffers pooled by calling thread
+    ///
+    static void releaseScratch();
+
+    ///
+    /// \brief Overwrites size bytes of data with zeros in a way that is not optimized away
+    ///
+    static void secureWipe(void* data, std::size_t size);
+
+    ///
+    /// \brief Temporary buffer drawn from calling thread's scratch pool and returned to it when destroyed,
+    /// so hot paths (packet building, key decoding) reuse buffers instead of allocating for every message.
+    ///
+    /// Sensitive buffers (key material, plain data) are wiped with secureWipe(void*, std::size_t) on release.
+    ///
+    class ScratchBuffer {
+    public:
+        explicit ScratchBuffer(std::size_t size = 0, bool sensitive = false);
+
+        ScratchBuffer(ScratchBuffer&& other);
+
+        ScratchBuffer& operator=(ScratchBuffer&& other);
+
+        ~ScratchBuffer();
+
+        ScratchBuffer(const ScratchBuffer&) = delete;
+        ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+        ///
+        /// \brief Changes size, contents (up to smaller of sizes) are kept when buffer grows
+        ///
+        void resize(std::size_t size);
+
+        inline RipeByte* data()
+        {
+            return m_data;
+        }
+
+        inline const RipeByte* data() const
+        {
+            return m_data;
+        }
+
+        inline std::size_t size() const
+        {
+            return m_size;
+        }
+
+        inline std::size_t capacity() const
+        {
+            return m_capacity;
+        }
+
+        inline bool sensitive() const
+        {
+            return m_sensitive;
+        }
+
+    private:
+        RipeByte* m_data;
+        std::size_t m_size;
+        std::size_t m_capacity;
+        // Bytes that may have been written, wiped on release
+        std::size_t m_used;
+        bool m_sensitive;
+        std::shared_ptr<const ScratchAllocator> m_allocator;
+
+        void release();
+    };
+
+    ///
+    /// \brief AES context that computes key schedule once so it can be reused to
+    /// encrypt / decrypt many messages with same key and different initialization vectors.
+    /// Every mode (CBC encryption / decryption, GCM, CTR) is keyed on its first use so a context
+    /// only pays for modes it uses.
+    ///
+    /// Context is not thread-safe, use one context per thread.
+    ///
+    class AESContext {
+    public:
+        ///
+        /// \brief Creates context from raw key
+        /// \param keySize Must be 16, 24 or 32
+        ///
+        AESContext(const RipeByte* key, std::size_t keySize);
+
+        ///
+        /// \brief Creates context from hexadecimal key
+        ///
+        explicit AESContext(const std::string& hexKey);
+
+        AESContext(AESContext&&);
+        AESContext& operator=(AESContext&&);
+        ~AESContext();
+
+        ///
+        /// \brief Encrypts data (PKCS #7 padding)
+        /// \param iv Initialization vector, if empty, random is generated and stored in it
+        ///
+        std::string encrypt(const std::string& data, std::vector<RipeByte>& iv);
+
+        ///
+        /// \brief Decrypts data that was encrypted with the key of this context
+        ///
+        std::string decrypt(const std::string& data, const std::vector<RipeByte>& iv);
+
+        ///
+        /// \brief Encrypts data (PKCS #7 padding) with specified initialization vector
+        ///
+        std::string encrypt(const std::string& data, const AESIV& iv);
+
+        ///
+        /// \brief Decrypts data that was encrypted with the key of this context
+        ///
+        std::string decrypt(const std::string& data, const AESIV& iv);
+
+        ///
+        /// \brief Encrypts n bytes of input in to output buffer (PKCS #7 padding). Input and output may be same buffer.
+        /// \param outCap Capacity of output, must be at least expectedAESCipherLength(n)
+        /// \param iv Initialization vector of AES_BLOCK_SIZE bytes
+        /// \return Number of bytes written to output
+        /// \throws std::invalid_argument if output capacity is not enough
+        ///
+        std::size_t encrypt(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv);
+
+        ///
+        /// \brief Decrypts n bytes of input in to output buffer. Input and output may be same buffer.
+        /// \param outCap Capacity of output, must be at least n
+        /// \param iv Initialization vector of AES_BLOCK_SIZE bytes
+        /// \return Number of bytes written to output (i.e, size of plain data)
+        /// \throws std::invalid_argument if output capacity is not enough
+        ///
+        std::size_t decrypt(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv);
+
+        ///
+        /// \brief Encrypts and authenticates n bytes of input using AES-GCM. Output is cipher followed by AES_GCM_TAG_SIZE bytes of tag.
+        /// \param outCap Capacity of output, must be at least expectedAESGCMCipherLength(n)
+        /// \param iv Initialization vector (nonce) of AES_GCM_IV_SIZE bytes. Never re-use it with same key
+        /// \param additionalData Optional data that is authenticated but not encrypted
+        /// \return Number of bytes written to output
+        ///
+        std::size_t encryptGCM(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv,
+                               const RipeByte* additionalData = nullptr, std::size_t additionalDataSize = 0);
+
+        ///
+        /// \brief Verifies and decrypts AES-GCM cipher (cipher followed by tag)
+        /// \param outCap Capacity of output, must be at least n - AES_GCM_TAG_SIZE
+        /// \return Number of bytes written to output
+        /// \throws CryptoPP::InvalidCiphertext if authentication fails
+        ///
+        std::size_t decryptGCM(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv,
+                               const RipeByte* additionalData = nullptr, std::size_t additionalDataSize = 0);
+
+        ///
+        /// \brief Encrypts / decrypts (same operation) n bytes using AES-CTR. Output is same size as input.
+        /// \param iv Initial counter block of AES_BLOCK_SIZE bytes
+        /// \return Number of bytes written to output
+        ///
+        std::size_t processCTR(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv);
+
+        ///
+        /// \brief Size of the key in bytes
+        ///
+        std::size_t keySize() const;
+
+    private:
+        friend class Ripe;
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    ///
+    /// \brief Incremental AES (CBC with PKCS #7 padding) encryption / decryption so data of any size can be
+    /// processed with constant memory. Output is identical to encryptAES / decryptAES on whole data.
+    ///
+    /// Usage: init(), call update() for every chunk and final() once at the end. Stream can be re-used by calling init() again.
+    ///
+    class AESStream {
+    public:
+        enum Direction {
+            ENCRYPT,
+            DECRYPT
+        };
+
+        AESStream();
+        AESStream(AESStream&&);
+        AESStream& operator=(AESStream&&);
+        ~AESStream();
+
+        ///
+        /// \brief Starts new stream
+        /// \param keySize Must be 16, 24 or 32
+        /// \param iv Initialization vector of AES_BLOCK_SIZE bytes
+        ///
+        void init(Direction direction, const RipeByte* key, std::size_t keySize, const RipeByte* iv);
+
+        ///
+        /// \brief Processes n bytes of input in to output buffer
+        /// \param outCap Capacity of output, must be at least n + AES_BLOCK_SIZE
+        /// \return Number of bytes written to output
+        ///
+        std::size_t update(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap);
+
+        ///
+        /// \brief Processes chunk and appends result to output
+        ///
+        void update(const std::string& chunk, std::string& output);
+
+        ///
+        /// \brief Finishes the stream, i.e, writes padded last block when encrypting, verifies
+        /// and removes padding when decrypting
+        /// \param outCap Capacity of output, must be at least AES_BLOCK_SIZE
+        /// \return Number of bytes written to output
+        ///
+        std::size_t final(RipeByte* out, std::size_t outCap);
+
+        ///
+        /// \brief Finishes the stream and appends result to output
+        ///
+        void final(std::string& output);
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    ///
+    /// \brief Encrypts everything from input stream to output stream in chunks of STREAM_CHUNK_SIZE
+    /// \param iv Initialization vector of AES_BLOCK_SIZE bytes
+    /// \return Number of bytes written to output
+    ///
+    static std::size_t encryptAES(std::istream& in, std::ostream& out, const RipeByte* key, std::size_t keySize, const RipeByte* iv);
+
+    ///
+    /// \brief Decrypts everything from input stream to output stream in chunks of STREAM_CHUNK_SIZE
+    /// \param iv Initialization vector of AES_BLOCK_SIZE bytes
+    /// \return Number of bytes written to output
+    ///
+    static std::size_t decryptAES(std::istream& in, std::ostream& out, const RipeByte* key, std::size_t keySize, const RipeByte* iv);
+
+    ///
+    /// \brief Encrypts and authenticates data using AES-GCM
+    /// \param iv Initialization vector, if empty, random of AES_GCM_IV_SIZE bytes is generated and stored in it
+    /// \param additionalData Optional data that is authenticated but not encrypted
+    /// \return Cipher followed by authentication tag
+    ///
+    static std::string encryptAESGCM(const std::string& data, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv,
+                                     const std::string& additionalData = "");
+
+    ///
+    /// \brief Verifies and decrypts AES-GCM cipher
+    /// \throws CryptoPP::InvalidCiphertext if authentication fails
+    ///
+    static std::string decryptAESGCM(const std::string& data, const RipeByte* key, std::size_t keySize, const std::vector<RipeByte>& iv,
+                                     const std::string& additionalData = "");
+
+    ///
+    /// \brief Encrypts data using AES-CTR (no padding, cipher is same size as data)
+    /// \param iv Initial counter block, if empty, random is generated and stored in it
+    ///
+    static std::string encryptAESCTR(const std::string& data, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv);
+
+    ///
+    /// \brief Decrypts AES-CTR cipher
+    ///
+    static std::string decryptAESCTR(const std::string& data, const RipeByte* key, std::size_t keySize, const std::vector<RipeByte>& iv);
+
+    ///
+    /// \brief Encrypts data in to chunked container so it can be encrypted / decrypted on multiple threads.
+    ///
+    /// Data is split in to independent segments of segmentSize, each encrypted with its own random IV.
+    /// Container format (integers are big-endian):
+    /// <pre>"RIPC" [version:1] [mode:1] [reserved:2] [segmentSize:4] [plainSize:8] [IV of each segment] [cipher of each segment]</pre>
+    /// With AES_GCM, header and segment number are authenticated with every segment so segments cannot be re-ordered or truncated.
+    ///
+    /// \param mode AES_GCM (recommended) or AES_CBC
+    /// \param threads Number of threads, 0 for number of CPU cores
+    /// \param segmentSize Size of plain data in each segment, at most 64 * AES_SEGMENT_SIZE
+    ///
+    static std::string encryptAESChunked(const std::string& data, const RipeByte* key, std::size_t keySize,
+                                         AESMode mode = AES_GCM, unsigned int threads = 0,
+                                         std::size_t segmentSize = AES_SEGMENT_SIZE);
+
+    ///
+    /// \brief Decrypts container created using encryptAESChunked
+    /// \param threads Number of threads, 0 for number of CPU cores
+    ///
+    static std::string decryptAESChunked(const std::string& data, const RipeByte* key, std::size_t keySize, unsigned int threads = 0);
+
+    ///
+    /// \brief Encrypts file in to chunked container file. Only a few segments per thread are kept in memory at a time.
+    /// \see encryptAESChunked(const std::string&, const RipeByte*, std::size_t, AESMode, unsigned int, std::size_t)
+    ///
+    static void encryptAESFile(const std::string& inputFile, const std::string& outputFile, const RipeByte* key, std::size_t keySize,
+                               AESMode mode = AES_GCM, unsigned int threads = 0, std::size_t segmentSize = AES_SEGMENT_SIZE);
+
+    ///
+    /// \brief Decrypts chunked container file
+    /// \see decryptAESChunked(const std::string&, const RipeByte*, std::size_t, unsigned int)
+    ///
+    static void decryptAESFile(const std::string& inputFile, const std::string& outputFile, const RipeByte* key, std::size_t keySize,
+                               unsigned int threads = 0);
+
+    ///
+    /// \brief Expected size of chunked container when plainDataSize size data is encrypted
+    ///
+    static std::size_t expectedAESChunkedLength(std::size_t plainDataSize, AESMode mode = AES_GCM, std::size_t segmentSize = AES_SEGMENT_SIZE);
+
 
 
 
@@ -156,6 +610,7 @@ public:
     ///
     /// \brief encryptAES Encrypts data with provided symmetric key
     /// \param outputFile Optional, if provided instead of printing it to console data is saved to file and IV is printed on console
+    /// \throws std::invalid_argument if iv is not empty and not a valid IV (see parseIV())
     ///
     static std::string encryptAES(std::string& data, const std::string& hexKey, const std::string& clientId, const std::string& outputFile, const std::string& iv = "");
 
@@ -184,12 +639,46 @@ public:
         return (plainDataSize / AES_BLOCK_SIZE + 1) * AES_BLOCK_SIZE;
     }
 
+    ///
+    /// \brief Expected size of AES-GCM cipher (including tag) when plainDataSize size data is encrypted
+    ///
+    inline static std::size_t expectedAESGCMCipherLength(std::size_t plainDataSize)
+    {
+        return plainDataSize + AES_GCM_TAG_SIZE;
+    }
+
     ///
     /// \brief normalizeIV If IV with no space is provided e.g, <pre>67e56fee50e22a8c2ba05c0fb2932bfa:</pre> normalized IV
     /// is <pre>67 e5 6f ee 50 e2 2a 8c 2b a0 5c 0f b2 93 2b fa:</pre>
+    /// \deprecated parseIV accepts both forms, use that instead
     ///
     static bool normalizeHex(std::string& iv);
 
+    ///
+    /// \brief Parses hexadecimal IV, either condensed <pre>67e56fee50e22a8c2ba05c0fb2932bfa</pre> or
+    /// spaced <pre>67 e5 6f ee 50 e2 2a 8c 2b a0 5c 0f b2 93 2b fa</pre> form. Does not allocate.
+    /// \return False if input is not exactly 16 hexadecimal bytes (iv is not changed in that case)
+    ///
+    static bool parseIV(const char* hex, std::size_t n, AESIV& iv);
+
+    ///
+    /// \see parseIV(const char*, std::size_t, AESIV&)
+    ///
+    inline static bool parseIV(const std::string& hex, AESIV& iv)
+    {
+        return parseIV(hex.data(), hex.size(), iv);
+    }
+
+    ///
+    /// \brief Writes IV in condensed lower-case hexadecimal form to out (32 characters, not null-terminated)
+    ///
+    static void formatIV(const AESIV& iv, char* out);
+
+    ///
+    /// \brief IV in condensed lower-case hexadecimal form
+    ///
+    static std::string ivToString(const AESIV& iv);
+
 
 
     /*****************************************************************************************************/
@@ -206,6 +695,274 @@ public:
                 \*******************************************************************/
 
 
+    ///
+    /// \brief Validation level used when loading RSA keys. Levels map to Crypto++ validation levels
+    /// (0 = cheap sanity checks, 3 = full primality and consistency checks)
+    ///
+    enum RSAKeyValidation {
+        ///
+        /// \brief Skip validation altogether, use it only for keys that are already trusted
+        ///
+        RSA_VALIDATION_NONE = -1,
+        RSA_VALIDATION_BASIC = 0,
+        RSA_VALIDATION_PARTIAL = 1,
+        RSA_VALIDATION_EXTENDED = 2,
+        RSA_VALIDATION_FULL = 3
+    };
+
+    ///
+    /// \brief Signature schemes that can be used with sign and verify. Signatures are always hex encoded
+    ///
+    enum SignatureScheme {
+        ///
+        /// \brief RSA PKCS #1 v1.5 with SHA-1, used by signRSA and verifyRSA
+        ///
+        SIGNATURE_RSA_PKCS1_SHA1 = 0,
+
+        ///
+        /// \brief RSA PSS with SHA-256 using same RSA keys
+        ///
+        SIGNATURE_RSA_PSS_SHA256 = 1,
+
+        ///
+        /// \brief Ed25519 with keys from generateEd25519KeyPair, much faster than RSA with 64-byte signatures.
+        /// Requires Crypto++ 8.0+
+        ///
+        SIGNATURE_ED25519 = 2
+    };
+
+    class RSADecryptor;
+    class RSASigner;
+    class Signer;
+    class Verifier;
+
+    ///
+    /// \brief Parsed RSA public key that can be reused across calls so PEM is only parsed
+    /// and validated once. Copies share the same underlying key.
+    ///
+    class RSAPublicKeyHandle {
+    public:
+        ///
+        /// \brief Loads public key from PEM
+        /// \throws std::invalid_argument if key does not pass validation
+        ///
+        explicit RSAPublicKeyHandle(const std::string& publicKeyPEM, RSAKeyValidation validation = RSA_VALIDATION_FULL);
+
+        ///
+        /// \brief Size of the key in bits (2048, 4096, ...)
+        ///
+        unsigned int keySize() const;
+
+    private:
+        friend class Ripe;
+        friend class Verifier;
+        struct Impl;
+        std::shared_ptr<Impl> m_impl;
+    };
+
+    ///
+    /// \brief Parsed RSA private key that can be reused across calls so PEM is only parsed,
+    /// decrypted and validated once. Copies share the same underlying key.
+    ///
+    class RSAPrivateKeyHandle {
+    public:
+        ///
+        /// \brief Loads private key from PEM
+        /// \param secret Private key secret (if any)
+        /// \throws std::invalid_argument if key does not pass validation
+        ///
+        explicit RSAPrivateKeyHandle(const std::string& privateKeyPEM, const std::string& secret = "", RSAKeyValidation validation = RSA_VALIDATION_FULL);
+
+        ///
+        /// \brief Size of the key in bits (2048, 4096, ...)
+        ///
+        unsigned int keySize() const;
+
+    private:
+        friend class Ripe;
+        friend class RSADecryptor;
+        friend class RSASigner;
+        friend class Signer;
+        struct Impl;
+        std::shared_ptr<Impl> m_impl;
+    };
+
+    ///
+    /// \brief Long-lived RSA (PKCS #1 v1.5) decryptor for a private key. Decryption scheme and its copy of the key
+    /// (including CRT parameters) are set up once instead of on every decryptRSA call.
+    /// A fresh blinding value is still used for every decryption.
+    ///
+    /// A decryptor is not thread-safe; keep one per worker thread. Decryptors of same handle do not share any state.
+    ///
+    class RSADecryptor {
+    public:
+        explicit RSADecryptor(const RSAPrivateKeyHandle& privateKey);
+        RSADecryptor(RSADecryptor&&);
+        RSADecryptor& operator=(RSADecryptor&&);
+        ~RSADecryptor();
+
+        ///
+        /// \brief Decrypts data that was encrypted with associated public key
+        /// \throws CryptoPP::Exception if data is not valid cipher for this key
+        ///
+        std::string decrypt(const std::string& data);
+
+    private:
+        friend class Ripe;
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    ///
+    /// \brief Long-lived RSA signer for a private key, set up once like RSADecryptor
+    ///
+    /// A signer is not thread-safe; keep one per worker thread. Signers of same handle do not share any state.
+    ///
+    class RSASigner {
+    public:
+        ///
+        /// \throws std::invalid_argument if scheme is not an RSA scheme
+        ///
+        explicit RSASigner(const RSAPrivateKeyHandle& privateKey, SignatureScheme scheme = SIGNATURE_RSA_PKCS1_SHA1);
+        RSASigner(RSASigner&&);
+        RSASigner& operator=(RSASigner&&);
+        ~RSASigner();
+
+        ///
+        /// \brief Signs the data
+        /// \return Hex format signature, same as signRSA
+        ///
+        std::string sign(const std::string& data);
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    ///
+    /// \brief Long-lived signer for any SignatureScheme (RSA or Ed25519). PEM is parsed once when signer is created,
+    /// copies reuse the parsed key so long-lived servers can keep one signer per worker thread.
+    ///
+    /// A signer is not thread-safe; keep one (copy) per worker thread.
+    ///
+    class Signer {
+    public:
+        ///
+        /// \param secret Private key secret, only supported for RSA keys
+        /// \throws std::invalid_argument if key cannot be loaded or scheme is not supported
+        ///
+        Signer(const std::string& privateKeyPEM, SignatureScheme scheme, const std::string& secret = "");
+        Signer(const Signer&);
+        Signer(Signer&&);
+        Signer& operator=(Signer&&);
+        ~Signer();
+
+        ///
+        /// \return Hex format signature, same as Ripe::sign
+        ///
+        std::string sign(const std::string& data);
+
+        SignatureScheme scheme() const;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    ///
+    /// \brief Long-lived verifier for any SignatureScheme, counterpart of Signer
+    ///
+    /// A verifier is not thread-safe; keep one (copy) per worker thread.
+    ///
+    class Verifier {
+    public:
+        ///
+        /// \throws std::invalid_argument if key cannot be loaded or scheme is not supported
+        ///
+        Verifier(const std::string& publicKeyPEM, SignatureScheme scheme);
+        Verifier(const Verifier&);
+        Verifier(Verifier&&);
+        Verifier& operator=(Verifier&&);
+        ~Verifier();
+
+        ///
+        /// \brief Verifies hex signature of data, same as Ripe::verify
+        ///
+        bool verify(const std::string& data, const std::string& signatureHex);
+
+        SignatureScheme scheme() const;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    ///
+    /// \brief Pool of RSA key pairs that are generated (and PEM encoded) on background threads so
+    /// callers do not wait for key generation
+    ///
+    /// Workers keep the pool filled up to target depth. All member functions are thread-safe.
+    /// Destructor waits for key pairs that are being generated.
+    ///
+    class KeyPairPool {
+    public:
+        ///
+        /// \brief Snapshot of pool state, generation times are in milliseconds
+        ///
+        struct Stats {
+            std::size_t depth;
+            std::size_t targetDepth;
+            std::size_t generated;
+            std::size_t acquired;
+            ///
+            /// \brief Number of acquire calls that found pool empty
+            ///
+            std::size_t misses;
+            std::size_t failures;
+            double lastGenerationTime;
+            double averageGenerationTime;
+            double maxGenerationTime;
+        };
+
+        ///
+        /// \param length Length of every key (2048 for 256-bit key, ...)
+        /// \param targetDepth Number of key pairs to keep ready
+        /// \param threads Number of background threads, 0 for number of CPU cores
+        /// \param secret Password for private keys (if any), keys are encrypted with PRIVATE_RSA_ALGORITHM
+        ///
+        explicit KeyPairPool(unsigned int length = DEFAULT_RSA_LENGTH, std::size_t targetDepth = 8, unsigned int threads = 1,
+                             const std::string& secret = "");
+        ~KeyPairPool();
+
+        KeyPairPool(const KeyPairPool&) = delete;
+        KeyPairPool& operator=(const KeyPairPool&) = delete;
+
+        ///
+        /// \brief Takes ready key pair out of the pool without blocking
+        /// \return False if pool is empty, pair is untouched in that case
+        ///
+        bool acquire(KeyPair& pair);
+
+        ///
+        /// \brief Takes ready key pair or generates one on calling thread if pool is empty
+        ///
+        KeyPair acquireOrGenerate();
+
+        ///
+        /// \brief Blocks until at least depth key pairs are ready (e.g, on startup)
+        /// \return False if timeout passed first or key generation failed
+        ///
+        bool waitForDepth(std::size_t depth, unsigned int timeoutMilliseconds);
+
+        std::size_t depth() const;
+
+        Stats stats() const;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
     ///
     /// \brief Encrypts data of length = dataLength using RSA key and puts it in destination
     ///
@@ -213,33 +970,156 @@ public:
     ///
     /// \return The size of the encrypted data. On error -1 is returned. use printLastError(const char*) to see the error details
     ///
-    static std::string encryptRSA(const std::string& data, const std::string& publicKeyPEM);
+    static std::string encryptRSA(const std::string& data, const std::string& publicKeyPEM);
+
+    ///
+    /// \brief Decrypts encryptedData of length dataLength with RSA key and puts result in destination
+    ///
+    /// Ripe uses PKCS #1 v1.5 padding scheme
+    ///
+    /// \return The size of the recovered plaintext. On error -1 is returned. use printLastError(const char* name) to see the error details
+    ///
+    static std::string decryptRSA(const std::string& data, const std::string& privateKeyPEM, const std::string& secret = "");
+
+    ///
+    /// \brief Verifies the data is signed by associated private key
+    /// \param data The data to verify
+    /// \param signatureHex Signature in hex format
+    /// \param publicKeyPEM Public key to verify the data from
+    ///
+    static bool verifyRSA(const std::string& data, const std::string& signatureHex, const std::string& publicKeyPEM);
+
+    ///
+    /// \brief Signs the data with private key
+    /// \param data The data to sign
+    /// \param privateKeyPEM private key to sign the data with
+    /// \param secret Private key secret
+    /// \return Hex format signature
+    ///
+    static std::string signRSA(const std::string& data, const std::string& privateKeyPEM, const std::string& secret = "");
+
+    ///
+    /// \brief Encrypts data using already loaded public key
+    /// \see encryptRSA(const std::string&, const std::string&)
+    ///
+    static std::string encryptRSA(const std::string& data, const RSAPublicKeyHandle& publicKey);
+
+    ///
+    /// \brief Decrypts data using already loaded private key. Use RSADecryptor for many decryptions with same key
+    /// \see decryptRSA(const std::string&, const std::string&, const std::string&)
+    ///
+    static std::string decryptRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey);
+
+    ///
+    /// \brief Verifies the data using already loaded public key
+    /// \see verifyRSA(const std::string&, const std::string&, const std::string&)
+    ///
+    static bool verifyRSA(const std::string& data, const std::string& signatureHex, const RSAPublicKeyHandle& publicKey);
+
+    ///
+    /// \brief Verifies the data using already loaded public key with specified RSA signature scheme
+    /// \throws std::invalid_argument if scheme is not an RSA scheme
+    ///
+    static bool verifyRSA(const std::string& data, const std::string& signatureHex, const RSAPublicKeyHandle& publicKey,
+                          SignatureScheme scheme);
+
+    ///
+    /// \brief Signs the data using already loaded private key. Use RSASigner for many signatures with same key
+    /// \see signRSA(const std::string&, const std::string&, const std::string&)
+    ///
+    static std::string signRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey);
+
+    ///
+    /// \brief Signs the data using already loaded private key with specified RSA signature scheme
+    /// \throws std::invalid_argument if scheme is not an RSA scheme
+    ///
+    static std::string signRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey, SignatureScheme scheme);
+
+    ///
+    /// \brief Signs every message with private key using multiple threads
+    /// \param threads Number of threads, 0 for number of CPU cores
+    /// \return Hex format signature of each message, in same order
+    ///
+    static std::vector<std::string> signRSABatch(const std::vector<std::string>& data, const RSAPrivateKeyHandle& privateKey,
+                                                 unsigned int threads = 0, SignatureScheme scheme = SIGNATURE_RSA_PKCS1_SHA1);
+
+    ///
+    /// \brief Verifies every message against its signature (signaturesHex[i] for data[i]) using multiple threads
+    /// \param threads Number of threads, 0 for number of CPU cores
+    /// \return Verification result of each message, in same order. Signatures that are not valid hex or of wrong size fail
+    /// \throws std::invalid_argument if number of signatures and messages are different
+    ///
+    static std::vector<bool> verifyRSABatch(const std::vector<std::string>& data, const std::vector<std::string>& signaturesHex,
+                                            const RSAPublicKeyHandle& publicKey, unsigned int threads = 0,
+                                            SignatureScheme scheme = SIGNATURE_RSA_PKCS1_SHA1);
+
+    ///
+    /// \brief Encrypts data of any size to public key. A random AES-256 key is encrypted with RSA and
+    /// data is encrypted with that key using AES-GCM
+    ///
+    /// Format: <pre>["RIPE"][version][0][encrypted key length (16-bit big-endian)][encrypted key][IV][cipher + tag]</pre>
+    /// Everything before IV is authenticated as additional data
+    ///
+    /// \return Binary envelope of expectedRSAEnvelopeLength(data.size(), publicKey.keySize()) bytes
+    ///
+    static std::string encryptRSAEnvelope(const std::string& data, const RSAPublicKeyHandle& publicKey);
+
+    ///
+    /// \see encryptRSAEnvelope(const std::string&, const RSAPublicKeyHandle&)
+    ///
+    static std::string encryptRSAEnvelope(const std::string& data, const std::string& publicKeyPEM);
+
+    ///
+    /// \brief Decrypts envelope from encryptRSAEnvelope
+    /// \throws std::invalid_argument if data is not an envelope
+    /// \throws CryptoPP::Exception if envelope was not encrypted for this key or it is tampered with
+    ///
+    static std::string decryptRSAEnvelope(const std::string& data, RSADecryptor& decryptor);
+
+    ///
+    /// \see decryptRSAEnvelope(const std::string&, RSADecryptor&)
+    ///
+    static std::string decryptRSAEnvelope(const std::string& data, const RSAPrivateKeyHandle& privateKey);
+
+    ///
+    /// \see decryptRSAEnvelope(const std::string&, RSADecryptor&)
+    ///
+    static std::string decryptRSAEnvelope(const std::string& data, const std::string& privateKeyPEM, const std::string& secret = "");
+
+    ///
+    /// \brief Signs the data with private key (RSA or Ed25519 PEM depending on scheme)
+    /// \param secret Private key secret, only supported for RSA keys
+    /// \return Hex format signature
+    /// \see SignatureScheme
+    ///
+    static std::string sign(const std::string& data, const std::string& privateKeyPEM, SignatureScheme scheme,
+                            const std::string& secret = "");
 
     ///
-    /// \brief Decrypts encryptedData of length dataLength with RSA key and puts result in destination
+    /// \brief Verifies the data is signed by associated private key using specified scheme
+    /// \see sign(const std::string&, const std::string&, SignatureScheme, const std::string&)
     ///
-    /// Ripe uses PKCS #1 v1.5 padding scheme
+    static bool verify(const std::string& data, const std::string& signatureHex, const std::string& publicKeyPEM,
+                       SignatureScheme scheme);
+
     ///
-    /// \return The size of the recovered plaintext. On error -1 is returned. use printLastError(const char* name) to see the error details
+    /// \brief Signs every message using multiple threads, key is only loaded once per thread
+    /// \see signRSABatch(const std::vector<std::string>&, const RSAPrivateKeyHandle&, unsigned int, SignatureScheme)
     ///
-    static std::string decryptRSA(const std::string& data, const std::string& privateKeyPEM, const std::string& secret = "");
+    static std::vector<std::string> signBatch(const std::vector<std::string>& data, const std::string& privateKeyPEM,
+                                              SignatureScheme scheme, const std::string& secret = "", unsigned int threads = 0);
 
     ///
-    /// \brief Verifies the data is signed by associated private key
-    /// \param data The data to verify
-    /// \param signatureHex Signature in hex format
-    /// \param publicKeyPEM Public key to verify the data from
+    /// \brief Verifies every message using multiple threads, key is only loaded once per thread
+    /// \see verifyRSABatch(const std::vector<std::string>&, const std::vector<std::string>&, const RSAPublicKeyHandle&, unsigned int, SignatureScheme)
     ///
-    static bool verifyRSA(const std::string& data, const std::string& signatureHex, const std::string& publicKeyPEM);
+    static std::vector<bool> verifyBatch(const std::vector<std::string>& data, const std::vector<std::string>& signaturesHex,
+                                         const std::string& publicKeyPEM, SignatureScheme scheme, unsigned int threads = 0);
 
     ///
-    /// \brief Signs the data with private key
-    /// \param data The data to sign
-    /// \param privateKeyPEM private key to sign the data with
-    /// \param secret Private key secret
-    /// \return Hex format signature
+    /// \brief Whether scheme is available with Crypto++ Ripe is built against
     ///
-    static std::string signRSA(const std::string& data, const std::string& privateKeyPEM, const std::string& secret = "");
+    static bool isSignatureSchemeSupported(SignatureScheme scheme);
 
     ///
     /// \brief Generate key pair and returns KeyPair
@@ -249,6 +1129,13 @@ public:
     ///
     static KeyPair generateRSAKeyPair(unsigned int length = DEFAULT_RSA_LENGTH, const std::string& secret = "");
 
+    ///
+    /// \brief Generates Ed25519 key pair for SIGNATURE_ED25519. Keys are PEM encoded PKCS #8 (private) and
+    /// X.509 (public), same as OpenSSL
+    /// \throws std::invalid_argument if Ed25519 is not supported
+    ///
+    static KeyPair generateEd25519KeyPair();
+
 
 
 
@@ -282,6 +1169,15 @@ public:
         return (dataSize + 11) * 8;
     }
 
+    ///
+    /// \brief Exact size of RSA envelope for data of plainDataSize with RSA key of keySize bits.
+    /// Unlike encryptRSA there is no limit on data size
+    ///
+    inline static std::size_t expectedRSAEnvelopeLength(std::size_t plainDataSize, std::size_t keySize)
+    {
+        return RSA_ENVELOPE_HEADER_SIZE + (keySize + 7) / 8 + AES_GCM_IV_SIZE + plainDataSize + AES_GCM_TAG_SIZE;
+    }
+
     ///
     /// \brief encryptRSA Encrypts using RSA key
     /// \param outputFile Optional, if provided instead of printing it to console data is saved to file
@@ -305,6 +1201,12 @@ public:
     ///
     static bool writeRSAKeyPair(const std::string& publicFile, const std::string& privateFile, int length = DEFAULT_RSA_LENGTH, const std::string& secret = "");
 
+    ///
+    /// \brief writeEd25519KeyPair Writes Ed25519 key pair to public and private file paths.
+    /// \see generateEd25519KeyPair()
+    ///
+    static bool writeEd25519KeyPair(const std::string& publicFile, const std::string& privateFile);
+
     ///
     /// \brief generateRSAKeyPair Generates RSA key pair and returns colon seperated base64 where first part is private key and second part is public key.
     ///
@@ -335,6 +1237,22 @@ public:
     ///
     static std::string base64Encode(const std::string& binaryData);
 
+    ///
+    /// \brief Encodes n bytes of input to base64 in to caller-provided output buffer
+    /// \param outCap Capacity of output, must be at least expectedBase64Length(n)
+    /// \return Number of bytes written to output
+    /// \throws std::invalid_argument if output capacity is not enough
+    ///
+    static std::size_t base64Encode(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap);
+
+    ///
+    /// \brief Decodes n bytes of base64 input in to caller-provided output buffer
+    /// \param outCap Capacity of output, must be at least maxBase64DecodedLength(n)
+    /// \return Number of bytes written to output
+    /// \throws std::invalid_argument if output capacity is not enough
+    ///
+    static std::size_t base64Decode(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap);
+
     ///
     /// \brief expectedBase64Length Returns expected base64 length
     /// \param n Length of input (plain data)
@@ -344,6 +1262,14 @@ public:
         return ((4 * n / 3) + 3) & ~0x03;
     }
 
+    ///
+    /// \brief Maximum length of decoded data when n bytes of base64 are decoded
+    ///
+    inline static std::size_t maxBase64DecodedLength(std::size_t n)
+    {
+        return (n * 3) / 4;
+    }
+
     ///
     /// \brief Finds whether data is base64 encoded. This is done
     /// by finding non-base64 character. So it is not necessary
@@ -369,12 +1295,159 @@ public:
                 \*******************************************************************/
 
     /**
-     * @brief Compress input file (path) and create new file
+     * @brief Compress input file (path) and create new gzip file
+     *
+     * Input is split in to 128 KB blocks that are compressed in parallel (same as pigz) and joined in to single
+     * gzip member that any gzip tool can decompress. Output does not depend on number of threads.
+     * Only few blocks per thread are kept in memory.
+     *
      * @param gzFilename Output file path
      * @param inputFile Input file path
-     * @return True if successful, otherwise false
+     * @param threads Number of threads, 0 for number of CPU cores
+     * @param level zlib compression level, -1 for zlib default (6)
+     * @return True if successful, otherwise exception is thrown
+     */
+    static bool compressFile(const std::string& gzFilename, const std::string& inputFile, unsigned int threads = 0, int level = -1);
+
+    /**
+     * @brief Decompresses gzip file (path) in to new file without loading it in to memory
+     * @param gzFilename Input gzip file path, concatenated gzip members are supported
+     * @param outputFile Output file path
+     * @return True if successful, otherwise exception is thrown
+     * @throws std::invalid_argument if input is not gzip file
+     */
+    static bool decompressFile(const std::string& gzFilename, const std::string& outputFile);
+
+    /**
+     * @brief Options for zlib compression, values are same as zlib's deflateInit2
+     */
+    struct ZlibOptions {
+        /**
+         * @brief Compression level, 1 (fastest) to 9 (best), 0 for no compression or -1 for zlib default (6)
+         */
+        int level;
+
+        /**
+         * @brief 8 to 15 for zlib format, add 16 for gzip format or negate for raw deflate.
+         * For decompression add 32 to detect zlib or gzip format automatically
+         */
+        int windowBits;
+
+        /**
+         * @brief zlib strategy, 0 (Z_DEFAULT_STRATEGY), 1 (Z_FILTERED), 2 (Z_HUFFMAN_ONLY), 3 (Z_RLE) or 4 (Z_FIXED)
+         */
+        int strategy;
+
+        /**
+         * @brief Memory used by compression state, 1 to 9
+         */
+        int memLevel;
+
+        /**
+         * @brief Defaults are same as compressString(const std::string&), i.e, best compression in zlib format
+         */
+        explicit ZlibOptions(int compressionLevel = 9, int window = 15, int zlibStrategy = 0, int memoryLevel = 8) :
+            level(compressionLevel),
+            windowBits(window),
+            strategy(zlibStrategy),
+            memLevel(memoryLevel)
+        {
+        }
+    };
+
+    /**
+     * @brief Incremental zlib compressor. Same stream (and its buffers) is reset and reused for every message,
+     * which is much faster than initializing new stream for small messages.
+     *
+     * A compressor is not thread-safe, keep one per thread.
+     */
+    class ZlibCompressor {
+    public:
+        /**
+         * @throws std::invalid_argument if options are not valid
+         */
+        explicit ZlibCompressor(const ZlibOptions& options = ZlibOptions());
+        ZlibCompressor(ZlibCompressor&&);
+        ZlibCompressor& operator=(ZlibCompressor&&);
+        ~ZlibCompressor();
+
+        /**
+         * @brief Compresses whole message. Must not be called in the middle of update / final
+         */
+        std::string compress(const std::string& data);
+
+        /**
+         * @brief Compresses whole message and appends it to output, output is sized with bound(n) up front
+         * @return Number of bytes appended
+         */
+        std::size_t compress(const RipeByte* in, std::size_t n, std::string& output);
+
+        /**
+         * @brief Compresses next part of current message and appends available output
+         */
+        void update(const RipeByte* in, std::size_t n, std::string& output);
+
+        /**
+         * @brief Finishes current message, appends rest of output and resets for next message
+         */
+        void final(std::string& output);
+
+        /**
+         * @brief Discards current message
+         */
+        void reset();
+
+        /**
+         * @brief Upper bound of compressed size of n bytes message (deflateBound)
+         */
+        std::size_t bound(std::size_t n) const;
+
+    private:
+        friend class Ripe;
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    /**
+     * @brief Incremental zlib decompressor, reused for every message like ZlibCompressor
+     *
+     * A decompressor is not thread-safe, keep one per thread.
      */
-    static bool compressFile(const std::string& gzFilename, const std::string& inputFile);
+    class ZlibDecompressor {
+    public:
+        /**
+         * @param options Only windowBits is used
+         * @throws std::invalid_argument if options are not valid
+         */
+        explicit ZlibDecompressor(const ZlibOptions& options = ZlibOptions());
+        ZlibDecompressor(ZlibDecompressor&&);
+        ZlibDecompressor& operator=(ZlibDecompressor&&);
+        ~ZlibDecompressor();
+
+        /**
+         * @brief Decompresses whole message
+         * @throws std::runtime_error if data is not valid or complete compressed message
+         */
+        std::string decompress(const std::string& data);
+
+        /**
+         * @brief Decompresses next part of current message and appends available output
+         * @return True if end of message is reached, decompressor is then reset for next message and
+         * rest of input is ignored
+         * @throws std::runtime_error if data is not valid
+         */
+        bool update(const RipeByte* in, std::size_t n, std::string& output);
+
+        /**
+         * @brief Discards current message
+         */
+        void reset();
+
+    private:
+        friend class Ripe;
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
 
     /**
      * @brief Compresses string using zlib (inflate)
@@ -383,6 +1456,13 @@ public:
      */
     static std::string compressString(const std::string& str);
 
+    /**
+     * @brief Compresses string with options, e.g, ZlibOptions(1) for fastest compression or
+     * ZlibOptions(9, 31) for gzip format
+     * @see ZlibCompressor to compress many messages
+     */
+    static std::string compressString(const std::string& str, const ZlibOptions& options);
+
     /**
      * @brief Decompresses string using zlib (deflate)
      * @param str Raw input
@@ -390,6 +1470,12 @@ public:
      */
     static std::string decompressString(const std::string& str);
 
+    /**
+     * @brief Decompresses string in format specified by options.windowBits
+     * @see ZlibDecompressor to decompress many messages
+     */
+    static std::string decompressString(const std::string& str, const ZlibOptions& options);
+
     /*****************************************************************************************************/
 
                 /*******************************************************************\
@@ -414,6 +1500,95 @@ public:
      */
     static std::string sha512Hash(const std::string&);
 
+    /**
+     * @brief Hash algorithms that can be used with Hasher and hashFile
+     */
+    enum HashAlgorithm {
+        HASH_SHA256 = 0,
+        HASH_SHA512 = 1,
+
+        /**
+         * @brief BLAKE2b with 64-byte digest, faster than SHA-2 in software. Requires Crypto++ 5.6.4+
+         */
+        HASH_BLAKE2B = 2
+    };
+
+    /**
+     * @brief Incremental hasher, message can be hashed in any number of parts. Hasher is reset by final
+     * so same object can be reused for next message.
+     *
+     * A hasher is not thread-safe, keep one per thread.
+     */
+    class Hasher {
+    public:
+        /**
+         * @throws std::invalid_argument if algorithm is not valid
+         */
+        explicit Hasher(HashAlgorithm algorithm = HASH_SHA256);
+        Hasher(Hasher&&);
+        Hasher& operator=(Hasher&&);
+        ~Hasher();
+
+        /**
+         * @brief Hashes next part of current message
+         */
+        void update(const RipeByte* in, std::size_t n);
+
+        void update(const std::string& data);
+
+        /**
+         * @brief Writes raw digest of current message in to out and resets for next message
+         * @param outCap Capacity of output, must be at least digestSize()
+         * @return Number of bytes written to output
+         * @throws std::invalid_argument if output capacity is not enough
+         */
+        std::size_t final(RipeByte* out, std::size_t outCap);
+
+        /**
+         * @brief Hex (upper-case) digest of current message (same as sha256Hash / sha512Hash) and resets for next message
+         */
+        std::string final();
+
+        /**
+         * @brief Discards current message
+         */
+        void reset();
+
+        /**
+         * @brief Size of raw digest in bytes (32 for SHA-256, 64 for SHA-512 and BLAKE2b)
+         */
+        std::size_t digestSize() const;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    /**
+     * @brief Hex (upper-case) digest of file contents. File is memory mapped (or read in large chunks where
+     * mapping is not possible) so memory use does not depend on size of file
+     * @throws std::runtime_error if file cannot be read
+     */
+    static std::string hashFile(const std::string& filename, HashAlgorithm algorithm = HASH_SHA256);
+
+    /**
+     * @brief Hashes every item of data on multiple threads
+     * @param threads Number of threads, 0 for all cores
+     * @return Raw digests one after another, digest of data[i] starts at i * hashDigestSize(algorithm)
+     */
+    static std::vector<RipeByte> hashBatch(const std::vector<std::string>& data, HashAlgorithm algorithm = HASH_SHA256,
+                                           unsigned int threads = 0);
+
+    /**
+     * @brief Size of raw digest of algorithm in bytes
+     */
+    static std::size_t hashDigestSize(HashAlgorithm algorithm);
+
+    /**
+     * @brief Whether algorithm is available with Crypto++ Ripe is built against
+     */
+    static bool isHashAlgorithmSupported(HashAlgorithm algorithm);
+
 
     /*****************************************************************************************************/
 
@@ -433,15 +1608,237 @@ public:
     /// \param clientId Extra text in between representing client ID (leave empty if you don't need it)
     /// \param ivec Init vector, if empty, random is generated
     /// \return Base64 format of encrypted data with format: <pre>[LENGTH]:[IV]:[[Client_ID]:]:[Base64 Data]</pre>
+    /// \throws std::invalid_argument if ivec is not empty and not a valid IV (see parseIV())
     ///
     static std::string prepareData(const std::string& data, const std::string& hexKey, const char* clientId = "", const std::string& ivec = "");
 
+    ///
+    /// \brief Builds prepared data (same format as prepareData(const std::string&, const std::string&, const char*, const std::string&))
+    /// and appends it to output. Output is grown once using expectedDataSize(std::size_t, std::size_t)
+    /// \param iv Initialization vector of AES_BLOCK_SIZE bytes, if nullptr random is generated
+    /// \return Number of bytes appended to output
+    ///
+    static std::size_t prepareData(const std::string& data, AESContext& context, std::string& output,
+                                   const std::string& clientId = "", const RipeByte* iv = nullptr);
+
+    ///
+    /// \brief Prepares each of data item (with its own random IV) and appends all the packets to output
+    /// \return Number of bytes appended to output
+    ///
+    static std::size_t prepareDataBatch(const std::vector<std::string>& data, AESContext& context, std::string& output,
+                                        const std::string& clientId = "");
+
+    ///
+    /// \brief Helper function that takes hex key
+    /// \see prepareDataBatch(const std::vector<std::string>&, AESContext&, std::string&, const std::string&)
+    ///
+    static std::string prepareDataBatch(const std::vector<std::string>& data, const std::string& hexKey, const std::string& clientId = "");
+
     ///
     /// \brief Calculates expected data size. Assumed IV size = 32
     /// \see prepareData(const char*, const std::string&, const char*)
     ///
     static std::size_t expectedDataSize(std::size_t plainDataSize, std::size_t clientIdSize = 16);
 
+    ///
+    /// \brief Compresses and prepares data in single pass. Deflate output is encrypted and base64 encoded in to output
+    /// a small chunk at a time so neither compressed nor encrypted data is held in full.
+    /// Result is the same as prepareData(compressor.compress(data), context, output, clientId, iv) (except for
+    /// compression level 0 where zlib sizes stored blocks by output space)
+    /// \param compressor Compressor to use, must not be in the middle of update / final
+    /// \param iv Initialization vector of AES_BLOCK_SIZE bytes, if nullptr random is generated
+    /// \return Number of bytes appended to output
+    ///
+    static std::size_t prepareCompressedData(const std::string& data, AESContext& context, ZlibCompressor& compressor,
+                                             std::string& output, const std::string& clientId = "", const RipeByte* iv = nullptr);
+
+    ///
+    /// \brief Helper function that takes hex key and uses default ZlibOptions
+    /// \see prepareCompressedData(const std::string&, AESContext&, ZlibCompressor&, std::string&, const std::string&, const RipeByte*)
+    ///
+    static std::string prepareCompressedData(const std::string& data, const std::string& hexKey, const std::string& clientId = "", const std::string& ivec = "");
+
+    ///
+    /// \brief Decrypts and decompresses data prepared using prepareCompressedData (or prepareData of compressed data).
+    /// Payload is base64 decoded, decrypted and inflated a small chunk at a time
+    /// \param clientId Client ID found in data
+    /// \throws std::invalid_argument if data is not valid prepared data
+    /// \throws CryptoPP::InvalidCiphertext if cipher length or padding is not valid
+    /// \throws std::runtime_error if decrypted data is not valid compressed data
+    ///
+    static std::string decryptCompressedData(const std::string& data, AESContext& context, ZlibDecompressor& decompressor,
+                                             std::string& clientId);
+
+    ///
+    /// \brief Helper function that takes hex key
+    /// \see decryptCompressedData(const std::string&, AESContext&, ZlibDecompressor&, std::string&)
+    ///
+    static std::string decryptCompressedData(const std::string& data, const std::string& hexKey);
+
+    ///
+    /// \brief prepareAuthenticatedData Similar to prepareData but uses AES-GCM so data is authenticated as well.
+    /// Client ID (if any) is authenticated (but not encrypted) along with data.
+    /// \param ivec Init vector (nonce), if empty, random is generated
+    /// \return Prepared data with format: <pre>[IV]:[[Client_ID]:]:[Base64 Data + Tag]</pre> where IV is AES_GCM_IV_SIZE bytes (24 hex characters)
+    ///
+    static std::string prepareAuthenticatedData(const std::string& data, const std::string& hexKey, const std::string& clientId = "", const std::string& ivec = "");
+
+    ///
+    /// \brief Builds authenticated prepared data and appends it to output
+    /// \param iv Initialization vector of AES_GCM_IV_SIZE bytes, if nullptr random is generated
+    /// \return Number of bytes appended to output
+    ///
+    static std::size_t prepareAuthenticatedData(const std::string& data, AESContext& context, std::string& output,
+                                                const std::string& clientId = "", const RipeByte* iv = nullptr);
+
+    ///
+    /// \brief Verifies and decrypts data prepared using prepareAuthenticatedData
+    /// \param clientId Client ID found in data
+    /// \throws CryptoPP::InvalidCiphertext if authentication fails
+    ///
+    static std::string decryptAuthenticatedData(const std::string& data, AESContext& context, std::string& clientId);
+
+    ///
+    /// \brief Helper function that takes hex key
+    /// \see decryptAuthenticatedData(const std::string&, AESContext&, std::string&)
+    ///
+    static std::string decryptAuthenticatedData(const std::string& data, const std::string& hexKey);
+
+    ///
+    /// \brief Calculates expected size of data prepared using prepareAuthenticatedData
+    ///
+    static std::size_t expectedAuthenticatedDataSize(std::size_t plainDataSize, std::size_t clientIdSize = 16);
+
+    ///
+    /// \brief Builds compact binary packet and appends it to output. Same as prepareData (AES_CBC) or
+    /// prepareAuthenticatedData (AES_GCM) without any text encoding, for links that do not need to be text-safe.
+    /// Format (sizes are big-endian): <pre>[Version << 4 | Mode (1 byte)][IV][Client ID size (2 bytes)][Client ID][Cipher size (4 bytes)][Cipher]</pre>
+    /// where IV is raw AES_BLOCK_SIZE (AES_CBC) or AES_GCM_IV_SIZE (AES_GCM) bytes
+    /// \param iv Initialization vector of IV size of the mode, if nullptr random is generated
+    /// \return Number of bytes appended to output
+    /// \throws std::invalid_argument if mode is not AES_CBC or AES_GCM or client ID is longer than 65535 bytes
+    ///
+    static std::size_t prepareBinaryData(const std::string& data, AESContext& context, std::string& output,
+                                         const std::string& clientId = "", AESMode mode = AES_CBC, const RipeByte* iv = nullptr);
+
+    ///
+    /// \brief Helper function that takes hex key
+    /// \param ivec Init vector (hex), if empty, random is generated
+    /// \see prepareBinaryData(const std::string&, AESContext&, std::string&, const std::string&, AESMode, const RipeByte*)
+    ///
+    static std::string prepareBinaryData(const std::string& data, const std::string& hexKey, const std::string& clientId = "",
+                                         AESMode mode = AES_CBC, const std::string& ivec = "");
+
+    ///
+    /// \brief Decrypts n bytes of single binary packet prepared using prepareBinaryData
+    /// \param clientId Client ID found in packet
+    /// \throws std::invalid_argument if data is not a valid binary packet
+    /// \throws CryptoPP::InvalidCiphertext if padding is not valid or authentication fails
+    ///
+    static std::string decryptBinaryData(const RipeByte* data, std::size_t n, AESContext& context, std::string& clientId);
+
+    static std::string decryptBinaryData(const std::string& data, AESContext& context, std::string& clientId);
+
+    ///
+    /// \brief Helper function that takes hex key
+    /// \see decryptBinaryData(const RipeByte*, std::size_t, AESContext&, std::string&)
+    ///
+    static std::string decryptBinaryData(const std::string& data, const std::string& hexKey);
+
+    ///
+    /// \brief Calculates exact size of packet prepared using prepareBinaryData
+    ///
+    static std::size_t expectedBinaryDataSize(std::size_t plainDataSize, std::size_t clientIdSize = 16, AESMode mode = AES_CBC);
+
+    ///
+    /// \brief Size of binary packet that starts at data, so stream of binary packets can be split in to packets
+    /// \param n Bytes available at data
+    /// \return Size of whole packet, 0 if n is not enough to read its header yet
+    /// \throws std::invalid_argument if data does not start with a binary packet
+    ///
+    static std::size_t binaryPacketSize(const RipeByte* data, std::size_t n);
+
+    ///
+    /// \brief Incremental decoder for stream of packets prepared using prepareData or prepareAuthenticatedData
+    /// (each followed by PACKET_DELIMITER), e.g, as received on a socket. Stream can be fed in chunks of
+    /// any size, complete packets are returned as views in to decoder's buffer without copying them.
+    ///
+    /// A decoder is not thread-safe, keep one per connection.
+    ///
+    class PacketDecoder {
+    public:
+        ///
+        /// \brief View of one packet, valid until next call to feed or clear
+        ///
+        struct Packet {
+            ///
+            /// \brief IV in hex, AES_BLOCK_SIZE * 2 characters for prepareData and AES_GCM_IV_SIZE * 2 for
+            /// prepareAuthenticatedData packets
+            ///
+            const char* iv;
+            std::size_t ivSize;
+            const char* clientId;
+            std::size_t clientIdSize;
+            ///
+            /// \brief Base64 cipher
+            ///
+            const char* payload;
+            std::size_t payloadSize;
+        };
+
+        ///
+        /// \param maxPacketSize Maximum size of a packet, buffered data that exceeds it without delimiter is an error
+        ///
+        explicit PacketDecoder(std::size_t maxPacketSize = 16 * 1024 * 1024);
+        PacketDecoder(PacketDecoder&&);
+        PacketDecoder& operator=(PacketDecoder&&);
+        ~PacketDecoder();
+
+        ///
+        /// \brief Appends next n bytes of stream, packets from previous calls that were not taken by next are kept
+        ///
+        void feed(const char* data, std::size_t n);
+
+        void feed(const std::string& data);
+
+        ///
+        /// \brief Takes next complete packet
+        /// \return False if there is no complete packet (yet)
+        /// \throws std::invalid_argument if packet is not valid (it is skipped, so decoding can continue) or
+        /// incomplete packet exceeds maximum packet size (buffered data is discarded)
+        ///
+        bool next(Packet& packet);
+
+        ///
+        /// \brief Decrypts packet (AES-CBC or AES-GCM depending on IV size) and appends plain data to output
+        /// \return Number of bytes appended
+        /// \throws std::invalid_argument if IV is not valid
+        /// \throws CryptoPP::InvalidCiphertext if padding is not valid or authentication fails
+        ///
+        std::size_t decrypt(const Packet& packet, AESContext& context, std::string& output);
+
+        ///
+        /// \brief Takes and decrypts all the complete packets. Plain data passed to fn is only valid during the call.
+        /// If a packet fails, exception is thrown and remaining packets can still be taken
+        /// \return Number of packets decrypted
+        ///
+        std::size_t decryptAll(AESContext& context, const std::function<void(const Packet& packet, const RipeByte* plain, std::size_t n)>& fn);
+
+        ///
+        /// \brief Number of bytes fed that are not taken yet
+        ///
+        std::size_t buffered() const;
+
+        ///
+        /// \brief Discards all buffered data
+        ///
+        void clear();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
     ///
     /// \brief Helper function to convert string to hexdecimal e.g, khn = 6b686e.
     ///
@@ -452,6 +1849,22 @@ public:
     ///
     static std::string hexToString(const std::string& hex);
 
+    ///
+    /// \brief Encodes n bytes of input to hexadecimal in to caller-provided output buffer
+    /// \param outCap Capacity of output, must be at least 2 * n
+    /// \return Number of bytes written to output
+    /// \throws std::invalid_argument if output capacity is not enough
+    ///
+    static std::size_t stringToHex(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap);
+
+    ///
+    /// \brief Decodes n bytes of hexadecimal input in to caller-provided output buffer
+    /// \param outCap Capacity of output, must be at least n / 2
+    /// \return Number of bytes written to output
+    /// \throws std::invalid_argument if output capacity is not enough
+    ///
+    static std::size_t hexToString(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap);
+
     ///
     /// \brief Converts vector of RipeByte to raw string
     ///
@@ -459,14 +1872,198 @@ public:
 
     ///
     /// \brief ivToVector Converts plain (unsigned char*) IV to std::vector<RipeByte>
+    /// \deprecated Use parseIV
     ///
     static std::vector<RipeByte> RipeByteToVec(const RipeByte* iv);
 
+    ///
+    /// \brief Thread pool for running Ripe operations off the caller's thread (e.g, event loop) where
+    /// results are received with std::future or completion callback
+    ///
+    /// Every worker has its own queue and idle workers steal from other queues. Tasks submitted from a
+    /// worker stay on its queue. Light tasks (AES, packets, hashing and encoding of buffers) are taken in
+    /// batches so short tasks do not synchronize one by one. Heavy tasks (RSA private key operations, key
+    /// generation, files) run on at most heavyThreads workers at a time, rest of the workers are always
+    /// available for light tasks.
+    ///
+    /// All member functions are thread-safe. Destructor runs tasks that are already submitted (tasks can
+    /// still submit more tasks) and waits for them.
+    ///
+    class Executor {
+    public:
+        enum TaskWeight {
+            TASK_LIGHT,
+            TASK_HEAVY
+        };
+
+        typedef std::function<void()> Task;
+
+        ///
+        /// \param threads Number of workers, 0 for number of CPU cores
+        /// \param heavyThreads Maximum number of workers running heavy tasks at a time, 0 for half of the workers.
+        /// Unless there is only one worker it is less than number of workers
+        ///
+        explicit Executor(unsigned int threads = 0, unsigned int heavyThreads = 0);
+        ~Executor();
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        ///
+        /// \brief Queues task without any result, exceptions thrown by task are ignored
+        ///
+        void post(Task task, TaskWeight weight = TASK_LIGHT);
+
+        ///
+        /// \brief Queues function and returns future of its result (or exception it throws)
+        ///
+        template <typename Function>
+        auto submit(Function function, TaskWeight weight = TASK_LIGHT) -> std::future<decltype(function())>
+        {
+            typedef decltype(function()) Result;
+            std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+            std::future<Result> result = task->get_future();
+            post([task]() { (*task)(); }, weight);
+            return result;
+        }
+
+        ///
+        /// \brief Queues function (that returns a value) and calls completion(result, error) with its result on
+        /// worker thread. If function throws, result is default constructed and error is the exception
+        ///
+        template <typename Function, typename Completion>
+        void submit(Function function, Completion completion, TaskWeight weight = TASK_LIGHT)
+        {
+            post([function, completion]() mutable {
+                decltype(function()) result{};
+                std::exception_ptr error;
+                try {
+                    result = function();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                completion(std::move(result), error);
+            }, weight);
+        }
+
+        ///
+        /// \brief Same as Ripe::generateRSAKeyPair, as heavy task
+        ///
+        std::future<KeyPair> generateRSAKeyPair(unsigned int length = DEFAULT_RSA_LENGTH, const std::string& secret = "");
+
+        ///
+        /// \brief Same as Ripe::decryptRSA, as heavy task
+        ///
+        std::future<std::string> decryptRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey);
+
+        ///
+        /// \brief Same as Ripe::signRSA, as heavy task
+        ///
+        std::future<std::string> signRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey,
+                                         SignatureScheme scheme = SIGNATURE_RSA_PKCS1_SHA1);
+
+        ///
+        /// \brief Same as Ripe::compressFile on single thread, as heavy task
+        ///
+        std::future<bool> compressFile(const std::string& gzFilename, const std::string& inputFile, int level = -1);
+
+        ///
+        /// \brief Same as Ripe::decompressFile, as heavy task
+        ///
+        std::future<bool> decompressFile(const std::string& gzFilename, const std::string& outputFile);
+
+        unsigned int threads() const;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
     ///
     /// \brief version Version of Ripe library
     ///
     static std::string version();
 
+    ///
+    /// \brief Hardware acceleration supported by the CPU and implementations selected for it at runtime
+    ///
+    struct CPUFeatures {
+        ///
+        /// \brief Architecture Ripe is built for, e.g, x86_64 or aarch64
+        ///
+        std::string architecture;
+
+        ///
+        /// \brief Relevant features supported by the CPU (and OS), e.g, aes, pclmul, sha, avx2 on x86
+        /// or aes, pmull, sha2, neon on ARM
+        ///
+        std::vector<std::string> features;
+
+        ///
+        /// \brief Implementations Crypto++ uses for AES, GCM (GHASH), SHA-256 and SHA-512, e.g, AESNI,
+        /// PCLMUL, SHANI, ARMv8, SSE2 or C++. Empty if Crypto++ is older than 6.0 and does not report them
+        ///
+        std::string aes;
+        std::string gcm;
+        std::string sha256;
+        std::string sha512;
+
+        ///
+        /// \brief Implementation of base64 and hex codecs, e.g, avx2, ssse3, neon or scalar
+        ///
+        std::string codec;
+    };
+
+    ///
+    /// \brief Detects hardware acceleration of this CPU. Every backend is selected at runtime so
+    /// same binary uses best implementation on each machine it runs on
+    ///
+    static CPUFeatures cpuFeatures();
+
+    ///
+    /// \brief Counters and latency histogram of one operation (or internal phase of an operation),
+    /// summed over all the threads since resetStats()
+    ///
+    struct OperationStats {
+        ///
+        /// \brief Name of operation, e.g, aes.encrypt, packet.prepare or rsa.validate
+        ///
+        std::string name;
+
+        std::uint64_t calls;
+
+        ///
+        /// \brief Input bytes processed (0 for operations where it does not apply)
+        ///
+        std::uint64_t bytes;
+
+        std::uint64_t totalNanoseconds;
+
+        std::uint64_t maxNanoseconds;
+
+        ///
+        /// \brief histogram[i] is number of calls that took [2^i, 2^(i+1)) nanoseconds (first bucket includes 0)
+        ///
+        std::vector<std::uint64_t> histogram;
+    };
+
+    ///
+    /// \brief Whether Ripe is built with instrumentation (RIPE_STATS, cmake -Dstats=ON). Without it
+    /// instrumentation is compiled out entirely and stats() is always empty
+    ///
+    static bool isStatsEnabled();
+
+    ///
+    /// \brief Snapshot of every instrumented operation. Each thread counts in to its own counters so
+    /// recording does not contend, snapshot sums them up
+    ///
+    static std::vector<OperationStats> stats();
+
+    ///
+    /// \brief Resets statistics of all the threads
+    ///
+    static void resetStats();
+
 private:
 
     Ripe() {}
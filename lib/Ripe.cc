@@ -22,28 +22,69 @@
 //  limitations under the License.
 //
 
+#include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <iomanip>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <sstream>
 #include <stdexcept>
 #include <fstream>
 #include <vector>
 #include <iostream>
 #include <iterator>
+#include <limits>
 
 #include <cryptopp/osrng.h>
-#include <cryptopp/base64.h>
 #include <cryptopp/modes.h>
+#include <cryptopp/gcm.h>
 #include <cryptopp/hex.h>
 #include <cryptopp/pem.h>
 #include <cryptopp/rsa.h>
+#include <cryptopp/pssr.h>
 #include <cryptopp/sha.h>
 #include <cryptopp/filters.h>
+#include <cryptopp/secblock.h>
+
+// BLAKE2 was added in Crypto++ 5.6.4
+#if CRYPTOPP_VERSION >= 564
+#   define RIPE_HAS_BLAKE2
+#   include <cryptopp/blake2.h>
+#endif
+
+// Ed25519 was added in Crypto++ 8.0
+#if CRYPTOPP_VERSION >= 800
+#   define RIPE_HAS_ED25519
+#   include <cryptopp/xed25519.h>
+#endif
 
 #include <zlib.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define RIPE_CPUID
+#   include <cpuid.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#   define RIPE_AUXV
+#   include <sys/auxv.h>
+#endif
+
 #include "../include/Ripe.h"
+#include "RipeCodec.h"
 
 #define RIPE_UNUSED(x) (void)x
 
@@ -55,41 +96,801 @@ const char        Ripe::DATA_DELIMITER        = ':';
 const int         Ripe::DEFAULT_RSA_LENGTH    = 2048;
 const int         Ripe::ZLIB_BUFFER_SIZE      = 32768;
 const int         Ripe::AES_BLOCK_SIZE             = AES::BLOCKSIZE;
+const int         Ripe::AES_GCM_IV_SIZE       = 12;
+const int         Ripe::AES_GCM_TAG_SIZE      = 16;
 const std::string Ripe::BASE64_CHARS          = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
 const std::string Ripe::PRIVATE_RSA_ALGORITHM = "AES-256-CBC";
+const std::size_t Ripe::STREAM_CHUNK_SIZE     = 1048576;
+const std::size_t Ripe::AES_SEGMENT_SIZE      = 1048576;
+const std::size_t Ripe::RANDOM_RESEED_INTERVAL = 1048576;
+const std::size_t Ripe::SCRATCH_POOL_LIMIT    = 4194304;
+const std::size_t Ripe::RSA_ENVELOPE_HEADER_SIZE = 8;
+const RipeByte    Ripe::BINARY_PACKET_VERSION = 1;
+
+struct Ripe::RSAPublicKeyHandle::Impl
+{
+    RSA::PublicKey key;
+};
+
+struct Ripe::RSAPrivateKeyHandle::Impl
+{
+    RSA::PrivateKey key;
+};
+
+#ifdef RIPE_STATS
+namespace {
+
+// Instrumented operations and phases, STATS_OPERATION_NAMES is in same order
+enum StatsOperation
+{
+    STATS_AES_KEY_SETUP,
+    STATS_AES_ENCRYPT,
+    STATS_AES_DECRYPT,
+    STATS_AES_GCM_ENCRYPT,
+    STATS_AES_GCM_DECRYPT,
+    STATS_AES_CHUNKED_ENCRYPT,
+    STATS_AES_CHUNKED_DECRYPT,
+    STATS_PACKET_PREPARE,
+    STATS_PACKET_PREPARE_AUTHENTICATED,
+    STATS_PACKET_DECRYPT_AUTHENTICATED,
+    STATS_PACKET_PREPARE_COMPRESSED,
+    STATS_PACKET_DECRYPT_COMPRESSED,
+    STATS_PACKET_DECODE,
+    STATS_PACKET_PREPARE_BINARY,
+    STATS_PACKET_DECRYPT_BINARY,
+    STATS_RSA_LOAD_KEY,
+    STATS_RSA_VALIDATE,
+    STATS_RSA_GENERATE_KEY,
+    STATS_RSA_ENCRYPT,
+    STATS_RSA_DECRYPT,
+    STATS_RSA_ENVELOPE_ENCRYPT,
+    STATS_RSA_ENVELOPE_DECRYPT,
+    STATS_SIGN,
+    STATS_VERIFY,
+    STATS_RANDOM_GENERATE,
+    STATS_RANDOM_RESEED,
+    STATS_BASE64_ENCODE,
+    STATS_BASE64_DECODE,
+    STATS_HEX_ENCODE,
+    STATS_HEX_DECODE,
+    STATS_ZLIB_COMPRESS,
+    STATS_ZLIB_DECOMPRESS,
+    STATS_HASH_UPDATE,
+    STATS_HASH_FILE,
+    STATS_OPERATION_COUNT
+};
+
+const char* const STATS_OPERATION_NAMES[STATS_OPERATION_COUNT] = {
+    "aes.keySetup",
+    "aes.encrypt",
+    "aes.decrypt",
+    "aes.gcm.encrypt",
+    "aes.gcm.decrypt",
+    "aes.chunked.encrypt",
+    "aes.chunked.decrypt",
+    "packet.prepare",
+    "packet.prepareAuthenticated",
+    "packet.decryptAuthenticated",
+    "packet.prepareCompressed",
+    "packet.decryptCompressed",
+    "packet.decode",
+    "packet.prepareBinary",
+    "packet.decryptBinary",
+    "rsa.loadKey",
+    "rsa.validate",
+    "rsa.generateKey",
+    "rsa.encrypt",
+    "rsa.decrypt",
+    "rsa.envelope.encrypt",
+    "rsa.envelope.decrypt",
+    "sign",
+    "verify",
+    "random.generate",
+    "random.reseed",
+    "base64.encode",
+    "base64.decode",
+    "hex.encode",
+    "hex.decode",
+    "zlib.compress",
+    "zlib.decompress",
+    "hash.update",
+    "hash.file",
+};
+
+const std::size_t STATS_HISTOGRAM_BUCKETS = 40;
+
+// Counters are written only by thread that owns them (plain load and store, no locked instruction),
+// they are atomic so that stats() can read them from any thread
+struct StatsCounters
+{
+    std::atomic<std::uint64_t> calls;
+    std::atomic<std::uint64_t> bytes;
+    std::atomic<std::uint64_t> totalNanoseconds;
+    std::atomic<std::uint64_t> maxNanoseconds;
+    std::atomic<std::uint64_t> histogram[STATS_HISTOGRAM_BUCKETS];
+};
+
+inline void addStatsCounter(std::atomic<std::uint64_t>& counter, std::uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+std::vector<Ripe::OperationStats> emptyStats()
+{
+    std::vector<Ripe::OperationStats> result(STATS_OPERATION_COUNT);
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        result[i].name = STATS_OPERATION_NAMES[i];
+        result[i].calls = result[i].bytes = result[i].totalNanoseconds = result[i].maxNanoseconds = 0;
+        result[i].histogram.assign(STATS_HISTOGRAM_BUCKETS, 0);
+    }
+    return result;
+}
+
+struct ThreadStats;
+
+std::atomic<unsigned int> statsGeneration(0);
+std::mutex statsMutex;
+// Following are guarded by statsMutex
+std::vector<ThreadStats*> statsThreads;
+// Counters of threads that have exited
+std::vector<Ripe::OperationStats> retiredStats = emptyStats();
+
+// 0 = not created yet, 1 = alive, 2 = destroyed (thread is exiting)
+thread_local int threadStatsState = 0;
+
+///
+/// \brief Counters of one thread, registered so that snapshot can include them
+///
+struct ThreadStats
+{
+    StatsCounters counters[STATS_OPERATION_COUNT];
+    // Counters older than statsGeneration were reset and are not read
+    std::atomic<unsigned int> generation;
+
+    ThreadStats() :
+        generation(statsGeneration.load())
+    {
+        zero();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        statsThreads.push_back(this);
+        threadStatsState = 1;
+    }
+
+    ~ThreadStats()
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        addTo(retiredStats);
+        statsThreads.erase(std::find(statsThreads.begin(), statsThreads.end(), this));
+        threadStatsState = 2;
+    }
+
+    void zero()
+    {
+        for (std::size_t i = 0; i < STATS_OPERATION_COUNT; ++i) {
+            StatsCounters& c = counters[i];
+            c.calls.store(0, std::memory_order_relaxed);
+            c.bytes.store(0, std::memory_order_relaxed);
+            c.totalNanoseconds.store(0, std::memory_order_relaxed);
+            c.maxNanoseconds.store(0, std::memory_order_relaxed);
+            for (std::size_t b = 0; b < STATS_HISTOGRAM_BUCKETS; ++b) {
+                c.histogram[b].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void record(StatsOperation operation, std::uint64_t bytes, std::uint64_t nanoseconds)
+    {
+        const unsigned int current = statsGeneration.load(std::memory_order_relaxed);
+        if (generation.load(std::memory_order_relaxed) != current) {
+            zero();
+            generation.store(current, std::memory_order_relaxed);
+        }
+        StatsCounters& c = counters[operation];
+        addStatsCounter(c.calls, 1);
+        addStatsCounter(c.bytes, bytes);
+        addStatsCounter(c.totalNanoseconds, nanoseconds);
+        if (nanoseconds > c.maxNanoseconds.load(std::memory_order_relaxed)) {
+            c.maxNanoseconds.store(nanoseconds, std::memory_order_relaxed);
+        }
+        std::size_t bucket = 0;
+        for (std::uint64_t v = nanoseconds >> 1; v != 0 && bucket + 1 < STATS_HISTOGRAM_BUCKETS; v >>= 1) {
+            ++bucket;
+        }
+        addStatsCounter(c.histogram[bucket], 1);
+    }
+
+    // Needs statsMutex
+    void addTo(std::vector<Ripe::OperationStats>& totals) const
+    {
+        if (generation.load(std::memory_order_relaxed) != statsGeneration.load(std::memory_order_relaxed)) {
+            return;
+        }
+        for (std::size_t i = 0; i < STATS_OPERATION_COUNT; ++i) {
+            const StatsCounters& c = counters[i];
+            Ripe::OperationStats& total = totals[i];
+            total.calls += c.calls.load(std::memory_order_relaxed);
+            total.bytes += c.bytes.load(std::memory_order_relaxed);
+            total.totalNanoseconds += c.totalNanoseconds.load(std::memory_order_relaxed);
+            total.maxNanoseconds = std::max<std::uint64_t>(total.maxNanoseconds, c.maxNanoseconds.load(std::memory_order_relaxed));
+            for (std::size_t b = 0; b < STATS_HISTOGRAM_BUCKETS; ++b) {
+                total.histogram[b] += c.histogram[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+void recordStats(StatsOperation operation, std::uint64_t bytes, std::uint64_t nanoseconds)
+{
+    if (threadStatsState == 2) {
+        return;
+    }
+    static thread_local ThreadStats threadStats;
+    threadStats.record(operation, bytes, nanoseconds);
+}
+
+///
+/// \brief Records duration of enclosing scope (including when it exits with exception)
+///
+class StatsScope
+{
+public:
+    StatsScope(StatsOperation operation, std::uint64_t bytes) :
+        m_operation(operation),
+        m_bytes(bytes),
+        m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~StatsScope()
+    {
+        const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - m_start;
+        recordStats(m_operation, m_bytes, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+private:
+    StatsOperation m_operation;
+    std::uint64_t m_bytes;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace
+
+#   define RIPE_STATS_SCOPE(operation, bytes) StatsScope ripeStatsScope(operation, static_cast<std::uint64_t>(bytes))
+#else
+// Arguments are not evaluated so disabled instrumentation costs nothing
+#   define RIPE_STATS_SCOPE(operation, bytes)
+#endif
+
+bool Ripe::isStatsEnabled()
+{
+#ifdef RIPE_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::vector<Ripe::OperationStats> Ripe::stats()
+{
+#ifdef RIPE_STATS
+    std::lock_guard<std::mutex> lock(statsMutex);
+    std::vector<OperationStats> result = retiredStats;
+    for (std::vector<ThreadStats*>::const_iterator it = statsThreads.begin(); it != statsThreads.end(); ++it) {
+        (*it)->addTo(result);
+    }
+    return result;
+#else
+    return std::vector<OperationStats>();
+#endif
+}
+
+void Ripe::resetStats()
+{
+#ifdef RIPE_STATS
+    // Threads zero their own counters when they record next time, until then they are skipped
+    std::lock_guard<std::mutex> lock(statsMutex);
+    retiredStats = emptyStats();
+    ++statsGeneration;
+#endif
+}
+
+namespace {
+
+std::atomic<std::size_t> randomReseedInterval(Ripe::RANDOM_RESEED_INTERVAL);
+std::atomic<unsigned int> randomForkGeneration(0);
+std::atomic<bool> hasCustomRandomGenerator(false);
+std::mutex customRandomGeneratorMutex;
+std::shared_ptr<Ripe::RandomGenerator> customRandomGenerator;
+
+#ifndef _WIN32
+void onRandomFork()
+{
+    // Child must not continue parent's random sequence
+    ++randomForkGeneration;
+}
+
+const int randomForkHandler = pthread_atfork(nullptr, nullptr, onRandomFork);
+#endif
+
+///
+/// \brief Per-thread pool used by default random generator
+///
+struct ThreadRandomPool
+{
+    AutoSeededRandomPool pool;
+    std::size_t generated;
+    unsigned int generation;
+
+    ThreadRandomPool() :
+        generated(0),
+        generation(randomForkGeneration.load())
+    {
+    }
+
+    void generate(RipeByte* output, std::size_t size)
+    {
+        const unsigned int currentGeneration = randomForkGeneration.load();
+        if (generation != currentGeneration || generated >= randomReseedInterval.load(std::memory_order_relaxed)) {
+            RIPE_STATS_SCOPE(STATS_RANDOM_RESEED, 0);
+            pool.Reseed();
+            generated = 0;
+            generation = currentGeneration;
+        }
+        pool.GenerateBlock(output, size);
+        generated += size;
+    }
+};
+
+///
+/// \brief Crypto++ view of library random generator so it can be passed to Crypto++ APIs
+///
+class LibraryRandomNumberGenerator : public RandomNumberGenerator
+{
+public:
+    void GenerateBlock(RipeByte* output, size_t size)
+    {
+        Ripe::generateRandom(output, size);
+    }
+};
+
+} // namespace
+
+void Ripe::generateRandom(RipeByte* output, std::size_t size)
+{
+    RIPE_STATS_SCOPE(STATS_RANDOM_GENERATE, size);
+    if (hasCustomRandomGenerator.load(std::memory_order_acquire)) {
+        std::shared_ptr<RandomGenerator> generator;
+        {
+            std::lock_guard<std::mutex> lock(customRandomGeneratorMutex);
+            generator = customRandomGenerator;
+        }
+        if (generator) {
+            (*generator)(output, size);
+            return;
+        }
+    }
+    static thread_local ThreadRandomPool threadPool;
+    threadPool.generate(output, size);
+}
+
+void Ripe::setRandomGenerator(const RandomGenerator& generator)
+{
+    std::shared_ptr<RandomGenerator> replacement;
+    if (generator) {
+        replacement = std::make_shared<RandomGenerator>(generator);
+    }
+    std::lock_guard<std::mutex> lock(customRandomGeneratorMutex);
+    customRandomGenerator = replacement;
+    hasCustomRandomGenerator.store(static_cast<bool>(replacement), std::memory_order_release);
+}
+
+void Ripe::setRandomReseedInterval(std::size_t bytes)
+{
+    randomReseedInterval = bytes;
+}
+
+namespace {
+
+std::atomic<std::size_t> scratchPoolLimit(Ripe::SCRATCH_POOL_LIMIT);
+std::atomic<unsigned int> scratchAllocatorGeneration(0);
+std::mutex scratchAllocatorMutex;
+// Empty means default allocator (operator new[])
+std::shared_ptr<const Ripe::ScratchAllocator> scratchAllocator;
+
+// Capacities are rounded up so that a block can be reused for messages of similar size
+const std::size_t SCRATCH_MIN_CAPACITY = 256;
+
+struct ScratchBlock
+{
+    RipeByte* data;
+    std::size_t capacity;
+    std::shared_ptr<const Ripe::ScratchAllocator> allocator;
+};
+
+std::shared_ptr<const Ripe::ScratchAllocator> currentScratchAllocator()
+{
+    std::lock_guard<std::mutex> lock(scratchAllocatorMutex);
+    return scratchAllocator;
+}
+
+void allocateScratchBlock(std::size_t size, ScratchBlock& block)
+{
+    std::size_t capacity = SCRATCH_MIN_CAPACITY;
+    while (capacity < size && capacity < Ripe::STREAM_CHUNK_SIZE) {
+        capacity <<= 1;
+    }
+    if (capacity < size) {
+        capacity = (size + Ripe::STREAM_CHUNK_SIZE - 1) / Ripe::STREAM_CHUNK_SIZE * Ripe::STREAM_CHUNK_SIZE;
+    }
+    block.data = block.allocator ? block.allocator->allocate(capacity) : new RipeByte[capacity];
+    if (block.data == nullptr) {
+        throw std::bad_alloc();
+    }
+    block.capacity = capacity;
+}
+
+void freeScratchBlock(ScratchBlock& block)
+{
+    if (block.allocator) {
+        block.allocator->deallocate(block.data, block.capacity);
+    } else {
+        delete[] block.data;
+    }
+    block.data = nullptr;
+    block.allocator.reset();
+}
+
+// 0 = not created yet, 1 = alive, 2 = destroyed (thread is exiting)
+thread_local int scratchPoolState = 0;
+
+///
+/// \brief Free scratch blocks of a thread
+///
+struct ScratchPool
+{
+    std::vector<ScratchBlock> blocks;
+    std::size_t pooled;
+    unsigned int generation;
+    std::shared_ptr<const Ripe::ScratchAllocator> allocator;
+
+    ScratchPool() :
+        pooled(0),
+        generation(scratchAllocatorGeneration.load(std::memory_order_acquire)),
+        allocator(currentScratchAllocator())
+    {
+        scratchPoolState = 1;
+    }
+
+    ~ScratchPool()
+    {
+        clear();
+        scratchPoolState = 2;
+    }
+
+    void clear()
+    {
+        for (std::vector<ScratchBlock>::iterator it = blocks.begin(); it != blocks.end(); ++it) {
+            freeScratchBlock(*it);
+        }
+        blocks.clear();
+        pooled = 0;
+    }
+
+    // Blocks of previous allocator are not handed out once allocator is replaced
+    void sync()
+    {
+        const unsigned int current = scratchAllocatorGeneration.load(std::memory_order_acquire);
+        if (generation != current) {
+            clear();
+            allocator = currentScratchAllocator();
+            generation = current;
+        }
+    }
+
+    void take(std::size_t size, ScratchBlock& block)
+    {
+        sync();
+        // Smallest block that fits
+        std::size_t best = blocks.size();
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            if (blocks[i].capacity >= size && (best == blocks.size() || blocks[i].capacity < blocks[best].capacity)) {
+                best = i;
+            }
+        }
+        if (best == blocks.size()) {
+            block.allocator = allocator;
+            allocateScratchBlock(size, block);
+            return;
+        }
+        pooled -= blocks[best].capacity;
+        block = std::move(blocks[best]);
+        if (best != blocks.size() - 1) {
+            blocks[best] = std::move(blocks.back());
+        }
+        blocks.pop_back();
+    }
+
+    void put(ScratchBlock& block)
+    {
+        sync();
+        if (block.allocator != allocator || pooled + block.capacity > scratchPoolLimit.load(std::memory_order_relaxed)) {
+            freeScratchBlock(block);
+            return;
+        }
+        pooled += block.capacity;
+        blocks.push_back(std::move(block));
+        block.data = nullptr;
+    }
+};
+
+ScratchPool& threadScratchPool()
+{
+    static thread_local ScratchPool pool;
+    return pool;
+}
+
+} // namespace
+
+void Ripe::setScratchAllocator(const ScratchAllocator& allocator)
+{
+    std::shared_ptr<const ScratchAllocator> replacement;
+    if (allocator.allocate && allocator.deallocate) {
+        replacement = std::make_shared<const ScratchAllocator>(allocator);
+    }
+    std::lock_guard<std::mutex> lock(scratchAllocatorMutex);
+    scratchAllocator = replacement;
+    scratchAllocatorGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void Ripe::setScratchPoolLimit(std::size_t bytes)
+{
+    scratchPoolLimit = bytes;
+}
+
+void Ripe::releaseScratch()
+{
+    if (scratchPoolState == 1) {
+        threadScratchPool().clear();
+    }
+}
+
+void Ripe::secureWipe(void* data, std::size_t size)
+{
+    SecureWipeArray(static_cast<RipeByte*>(data), size);
+}
+
+Ripe::ScratchBuffer::ScratchBuffer(std::size_t size, bool sensitive) :
+    m_data(nullptr),
+    m_size(0),
+    m_capacity(0),
+    m_used(0),
+    m_sensitive(sensitive)
+{
+    resize(size);
+}
+
+Ripe::ScratchBuffer::ScratchBuffer(ScratchBuffer&& other) :
+    m_data(other.m_data),
+    m_size(other.m_size),
+    m_capacity(other.m_capacity),
+    m_used(other.m_used),
+    m_sensitive(other.m_sensitive),
+    m_allocator(std::move(other.m_allocator))
+{
+    other.m_data = nullptr;
+    other.m_size = other.m_capacity = other.m_used = 0;
+}
+
+Ripe::ScratchBuffer& Ripe::ScratchBuffer::operator=(ScratchBuffer&& other)
+{
+    if (this != &other) {
+        release();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        m_used = other.m_used;
+        m_sensitive = other.m_sensitive;
+        m_allocator = std::move(other.m_allocator);
+        other.m_data = nullptr;
+        other.m_size = other.m_capacity = other.m_used = 0;
+    }
+    return *this;
+}
+
+Ripe::ScratchBuffer::~ScratchBuffer()
+{
+    release();
+}
+
+void Ripe::ScratchBuffer::resize(std::size_t size)
+{
+    if (size > m_capacity) {
+        ScratchBlock block;
+        if (scratchPoolState != 2) {
+            threadScratchPool().take(size, block);
+        } else {
+            block.allocator = currentScratchAllocator();
+            allocateScratchBlock(size, block);
+        }
+        if (m_size > 0) {
+            std::copy(m_data, m_data + m_size, block.data);
+        }
+        const std::size_t kept = m_size;
+        release();
+        m_data = block.data;
+        m_capacity = block.capacity;
+        m_allocator = std::move(block.allocator);
+        m_used = kept;
+    }
+    m_size = size;
+    m_used = std::max(m_used, size);
+}
 
-bool loadPrivateKey(const std::string& key, RSA::PrivateKey& keyOut, const std::string& secret)
+void Ripe::ScratchBuffer::release()
 {
-    StringSource source(key, true);
-    if (secret.empty()) {
-        PEM_Load(source, keyOut);
+    if (m_data == nullptr) {
+        return;
+    }
+    if (m_sensitive) {
+        Ripe::secureWipe(m_data, m_used);
+    }
+    ScratchBlock block;
+    block.data = m_data;
+    block.capacity = m_capacity;
+    block.allocator = std::move(m_allocator);
+    if (scratchPoolState != 2) {
+        threadScratchPool().put(block);
     } else {
-        PEM_Load(source, keyOut, secret.data(), secret.size());
+        freeScratchBlock(block);
+    }
+    m_data = nullptr;
+    m_size = m_capacity = m_used = 0;
+}
+
+namespace {
+
+unsigned int resolveThreadCount(unsigned int threads)
+{
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
     }
-    AutoSeededRandomPool prng;
-    return keyOut.Validate(prng, 3);
+    return threads == 0 ? 1 : threads;
 }
 
-bool loadPublicKey(const std::string& key, RSA::PublicKey& keyOut)
+// Shared by parallelFor calls so they do not create (and join) threads every time
+Ripe::Executor& parallelForPool()
 {
-    StringSource source(key, true);
-    PEM_Load(source, keyOut);
-    AutoSeededRandomPool prng;
-    return keyOut.Validate(prng, 3);
+    static Ripe::Executor pool;
+    return pool;
 }
 
-std::string Ripe::encryptRSA(const std::string& data, const std::string& publicKeyPEM)
+// Runs fn(item, worker) for every item in [0, count) on up to threads threads (caller's thread included)
+// and rethrows first exception (if any) once all the workers are done. Helpers run on parallelForPool(),
+// caller claims items too and only waits for helpers that are running an item, so it never waits for a
+// helper that is still queued (pool is busy, smaller than threads or caller is one of its workers)
+void parallelFor(std::size_t count, unsigned int threads, const std::function<void(std::size_t, unsigned int)>& fn)
+{
+    if (threads > count) {
+        threads = static_cast<unsigned int>(count);
+    }
+    if (threads <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(i, 0);
+        }
+        return;
+    }
+    struct State
+    {
+        std::atomic<std::size_t> next;
+        std::atomic<unsigned int> active;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->next = 0;
+    state->active = 0;
+    auto work = [state, count, &fn](unsigned int worker) {
+        for (std::size_t i = state->next++; i < count; i = state->next++) {
+            try {
+                fn(i, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error) {
+                    state->error = std::current_exception();
+                }
+                state->next = count;
+            }
+        }
+    };
+    for (unsigned int worker = 1; worker < threads; ++worker) {
+        parallelForPool().post([state, count, work, worker]() {
+            // Helper that becomes active after all the items are claimed does not touch fn (which may be gone)
+            ++state->active;
+            if (state->next < count) {
+                work(worker);
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (--state->active == 0) {
+                state->done.notify_all();
+            }
+        });
+    }
+    work(0);
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->active == 0; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+bool validateRSAKey(const RSA::PublicKey& key, Ripe::RSAKeyValidation validation)
+{
+    RIPE_STATS_SCOPE(STATS_RSA_VALIDATE, 0);
+    if (validation == Ripe::RSA_VALIDATION_NONE) {
+        return true;
+    }
+    LibraryRandomNumberGenerator rng;
+    return key.Validate(rng, static_cast<unsigned int>(validation));
+}
+
+} // namespace
+
+Ripe::RSAPublicKeyHandle::RSAPublicKeyHandle(const std::string& publicKeyPEM, RSAKeyValidation validation) :
+    m_impl(std::make_shared<Impl>())
 {
-    RSA::PublicKey publicKey;
-    bool rsaKeyValid = loadPublicKey(publicKeyPEM, publicKey);
-    if (!rsaKeyValid) {
+    {
+        RIPE_STATS_SCOPE(STATS_RSA_LOAD_KEY, publicKeyPEM.size());
+        StringSource source(publicKeyPEM, true);
+        PEM_Load(source, m_impl->key);
+    }
+    if (!validateRSAKey(m_impl->key, validation)) {
         throw std::invalid_argument("Could not load public key");
     }
+}
+
+unsigned int Ripe::RSAPublicKeyHandle::keySize() const
+{
+    return m_impl->key.GetModulus().BitCount();
+}
+
+Ripe::RSAPrivateKeyHandle::RSAPrivateKeyHandle(const std::string& privateKeyPEM, const std::string& secret, RSAKeyValidation validation) :
+    m_impl(std::make_shared<Impl>())
+{
+    {
+        RIPE_STATS_SCOPE(STATS_RSA_LOAD_KEY, privateKeyPEM.size());
+        StringSource source(privateKeyPEM, true);
+        if (secret.empty()) {
+            PEM_Load(source, m_impl->key);
+        } else {
+            PEM_Load(source, m_impl->key, secret.data(), secret.size());
+        }
+    }
+    if (!validateRSAKey(m_impl->key, validation)) {
+        throw std::invalid_argument("Could not load private key");
+    }
+}
 
-    RSAES<PKCS1v15>::Encryptor e(publicKey);
+unsigned int Ripe::RSAPrivateKeyHandle::keySize() const
+{
+    return m_impl->key.GetModulus().BitCount();
+}
+
+std::string Ripe::encryptRSA(const std::string& data, const std::string& publicKeyPEM)
+{
+    return Ripe::encryptRSA(data, RSAPublicKeyHandle(publicKeyPEM));
+}
+
+std::string Ripe::encryptRSA(const std::string& data, const RSAPublicKeyHandle& publicKey)
+{
+    RIPE_STATS_SCOPE(STATS_RSA_ENCRYPT, data.size());
+    RSAES<PKCS1v15>::Encryptor e(publicKey.m_impl->key);
 
     std::string result;
-    AutoSeededRandomPool rng;
+    LibraryRandomNumberGenerator rng;
     StringSource ss(data, true,
         new PK_EncryptorFilter(rng, e,
             new StringSink(result)
@@ -107,8 +908,8 @@ std::string Ripe::encryptRSA(std::string& data, const std::string& key, const st
             encryptedData = Ripe::base64Encode(encryptedData);
         }
         if (!outputFile.empty()) {
-            std::ofstream out(outputFile.c_str());
-            out.write(encryptedData.c_str(), encryptedData.size());
+            std::ofstream out(outputFile.c_str(), std::ios::out | std::ios::binary);
+            out.write(encryptedData.data(), encryptedData.size());
             out.flush();
             out.close();
             return "";
@@ -121,24 +922,13 @@ std::string Ripe::encryptRSA(std::string& data, const std::string& key, const st
 
 std::string Ripe::decryptRSA(const std::string& data, const std::string& privateKeyPEM, const std::string& secret)
 {
-    RSA::PrivateKey privateKey;
-    bool rsaKeyValid = loadPrivateKey(privateKeyPEM, privateKey, secret);
-    if (!rsaKeyValid) {
-        throw std::invalid_argument("Could not load private key");
-    }
+    return Ripe::decryptRSA(data, RSAPrivateKeyHandle(privateKeyPEM, secret));
+}
 
-    std::string result;
-    AutoSeededRandomPool rng;
-    RSAES<PKCS1v15>::Decryptor d(privateKey);
-
-    StringSource ss(data, true,
-        new PK_DecryptorFilter(rng, d,
-            new StringSink(result)
-       )
-    );
-    RIPE_UNUSED(ss);
-    return result;
-}
+std::string Ripe::decryptRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey)
+{
+    return RSADecryptor(privateKey).decrypt(data);
+}
 
 std::string Ripe::decryptRSA(std::string& data, const std::string& key, bool isBase64, bool isHex, const std::string& secret)
 {
@@ -152,408 +942,3286 @@ std::string Ripe::decryptRSA(std::string& data, const std::string& key, bool isB
     return Ripe::decryptRSA(data, key, secret);
 }
 
-bool Ripe::verifyRSA(const std::string& data, const std::string& signatureHex, const std::string& publicKeyPEM)
+bool Ripe::verifyRSA(const std::string& data, const std::string& signatureHex, const std::string& publicKeyPEM)
+{
+    return Ripe::verifyRSA(data, signatureHex, RSAPublicKeyHandle(publicKeyPEM));
+}
+
+namespace {
+
+std::unique_ptr<PK_Signer> createRSASigner(const RSA::PrivateKey& key, Ripe::SignatureScheme scheme)
+{
+    switch (scheme) {
+    case Ripe::SIGNATURE_RSA_PKCS1_SHA1:
+        return std::unique_ptr<PK_Signer>(new RSASS<PKCS1v15, SHA1>::Signer(key));
+    case Ripe::SIGNATURE_RSA_PSS_SHA256:
+        return std::unique_ptr<PK_Signer>(new RSASS<PSS, SHA256>::Signer(key));
+    default:
+        throw std::invalid_argument("Signature scheme can not be used with RSA key");
+    }
+}
+
+std::unique_ptr<PK_Verifier> createRSAVerifier(const RSA::PublicKey& key, Ripe::SignatureScheme scheme)
+{
+    switch (scheme) {
+    case Ripe::SIGNATURE_RSA_PKCS1_SHA1:
+        return std::unique_ptr<PK_Verifier>(new RSASS<PKCS1v15, SHA1>::Verifier(key));
+    case Ripe::SIGNATURE_RSA_PSS_SHA256:
+        return std::unique_ptr<PK_Verifier>(new RSASS<PSS, SHA256>::Verifier(key));
+    default:
+        throw std::invalid_argument("Signature scheme can not be used with RSA key");
+    }
+}
+
+bool verifySignature(const PK_Verifier& verifier, const std::string& data, const std::string& signatureHex)
+{
+    RIPE_STATS_SCOPE(STATS_VERIFY, data.size());
+    // Signature is decoded in to reused buffer and verified on its own instead of prepending it to data
+    static thread_local std::vector<RipeByte> signature;
+    signature.resize(signatureHex.size() / 2);
+    signature.resize(Ripe::hexToString(reinterpret_cast<const RipeByte*>(signatureHex.data()), signatureHex.size(),
+                                       signature.data(), signature.size()));
+    if (signature.size() != verifier.SignatureLength()) {
+        return false;
+    }
+    return verifier.VerifyMessage(reinterpret_cast<const RipeByte*>(data.data()), data.size(), signature.data(), signature.size());
+}
+
+std::string signMessage(const PK_Signer& signer, const std::string& data)
+{
+    RIPE_STATS_SCOPE(STATS_SIGN, data.size());
+    static thread_local std::vector<RipeByte> signature;
+    signature.resize(signer.MaxSignatureLength());
+    LibraryRandomNumberGenerator rng;
+    const std::size_t length = signer.SignMessage(rng, reinterpret_cast<const RipeByte*>(data.data()), data.size(), signature.data());
+    std::string signatureHex(length * 2, '\0');
+    Ripe::stringToHex(signature.data(), length, reinterpret_cast<RipeByte*>(&signatureHex[0]), signatureHex.size());
+    return signatureHex;
+}
+
+} // namespace
+
+struct Ripe::RSADecryptor::Impl
+{
+    RSAES<PKCS1v15>::Decryptor decryptor;
+
+    explicit Impl(const RSA::PrivateKey& key) :
+        decryptor(key)
+    {
+    }
+};
+
+Ripe::RSADecryptor::RSADecryptor(const RSAPrivateKeyHandle& privateKey) :
+    m_impl(new Impl(privateKey.m_impl->key))
+{
+}
+
+Ripe::RSADecryptor::RSADecryptor(RSADecryptor&&) = default;
+
+Ripe::RSADecryptor& Ripe::RSADecryptor::operator=(RSADecryptor&&) = default;
+
+Ripe::RSADecryptor::~RSADecryptor()
+{
+}
+
+std::string Ripe::RSADecryptor::decrypt(const std::string& data)
+{
+    RIPE_STATS_SCOPE(STATS_RSA_DECRYPT, data.size());
+    // Decrypt writes up to FixedMaxPlaintextLength bytes whatever the input size, so input that is not
+    // exactly one RSA block is rejected before any output is written
+    if (data.size() != m_impl->decryptor.FixedCiphertextLength()) {
+        throw InvalidCiphertext("RSA: ciphertext length does not match key length");
+    }
+    LibraryRandomNumberGenerator rng;
+    std::string result(m_impl->decryptor.FixedMaxPlaintextLength(), '\0');
+    const DecodingResult decoded = m_impl->decryptor.Decrypt(rng, reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+                                                             reinterpret_cast<RipeByte*>(&result[0]));
+    if (!decoded.isValidCoding) {
+        // Same error as PK_DecryptorFilter that was used previously
+        throw InvalidCiphertext("PK_DecryptorFilter: invalid ciphertext");
+    }
+    result.resize(decoded.messageLength);
+    return result;
+}
+
+struct Ripe::RSASigner::Impl
+{
+    std::unique_ptr<PK_Signer> signer;
+
+    Impl(const RSA::PrivateKey& key, SignatureScheme scheme) :
+        signer(createRSASigner(key, scheme))
+    {
+    }
+};
+
+Ripe::RSASigner::RSASigner(const RSAPrivateKeyHandle& privateKey, SignatureScheme scheme) :
+    m_impl(new Impl(privateKey.m_impl->key, scheme))
+{
+}
+
+Ripe::RSASigner::RSASigner(RSASigner&&) = default;
+
+Ripe::RSASigner& Ripe::RSASigner::operator=(RSASigner&&) = default;
+
+Ripe::RSASigner::~RSASigner()
+{
+}
+
+std::string Ripe::RSASigner::sign(const std::string& data)
+{
+    return signMessage(*m_impl->signer, data);
+}
+
+bool Ripe::verifyRSA(const std::string& data, const std::string& signatureHex, const RSAPublicKeyHandle& publicKey)
+{
+    return Ripe::verifyRSA(data, signatureHex, publicKey, SIGNATURE_RSA_PKCS1_SHA1);
+}
+
+bool Ripe::verifyRSA(const std::string& data, const std::string& signatureHex, const RSAPublicKeyHandle& publicKey,
+                     SignatureScheme scheme)
+{
+    return verifySignature(*createRSAVerifier(publicKey.m_impl->key, scheme), data, signatureHex);
+}
+
+namespace {
+
+std::vector<bool> verifyMessages(const std::vector<std::string>& data, const std::vector<std::string>& signaturesHex,
+                                 unsigned int threads, const std::function<std::unique_ptr<PK_Verifier>()>& createVerifier)
+{
+    if (data.size() != signaturesHex.size()) {
+        throw std::invalid_argument("Number of signatures does not match number of messages");
+    }
+    threads = std::min<std::size_t>(resolveThreadCount(threads), std::max<std::size_t>(data.size(), 1));
+    std::vector<std::unique_ptr<PK_Verifier> > verifiers;
+    for (unsigned int i = 0; i < threads; ++i) {
+        verifiers.push_back(createVerifier());
+    }
+    // std::vector<bool> packs bits so workers write to separate bytes first
+    std::vector<char> verified(data.size(), 0);
+    parallelFor(data.size(), threads, [&](std::size_t i, unsigned int worker) {
+        verified[i] = verifySignature(*verifiers[worker], data[i], signaturesHex[i]);
+    });
+    return std::vector<bool>(verified.begin(), verified.end());
+}
+
+std::vector<std::string> signMessages(const std::vector<std::string>& data, unsigned int threads,
+                                      const std::function<std::unique_ptr<PK_Signer>()>& createSigner)
+{
+    threads = std::min<std::size_t>(resolveThreadCount(threads), std::max<std::size_t>(data.size(), 1));
+    std::vector<std::unique_ptr<PK_Signer> > signers;
+    for (unsigned int i = 0; i < threads; ++i) {
+        signers.push_back(createSigner());
+    }
+    std::vector<std::string> signatures(data.size());
+    parallelFor(data.size(), threads, [&](std::size_t i, unsigned int worker) {
+        signatures[i] = signMessage(*signers[worker], data[i]);
+    });
+    return signatures;
+}
+
+} // namespace
+
+std::vector<bool> Ripe::verifyRSABatch(const std::vector<std::string>& data, const std::vector<std::string>& signaturesHex,
+                                       const RSAPublicKeyHandle& publicKey, unsigned int threads, SignatureScheme scheme)
+{
+    return verifyMessages(data, signaturesHex, threads, [&]() {
+        return createRSAVerifier(publicKey.m_impl->key, scheme);
+    });
+}
+
+std::string Ripe::signRSA(const std::string& data, const std::string& privateKeyPEM, const std::string& privateKeySecret)
+{
+    return Ripe::signRSA(data, RSAPrivateKeyHandle(privateKeyPEM, privateKeySecret));
+}
+
+std::string Ripe::signRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey)
+{
+    return RSASigner(privateKey).sign(data);
+}
+
+std::string Ripe::signRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey, SignatureScheme scheme)
+{
+    return RSASigner(privateKey, scheme).sign(data);
+}
+
+std::vector<std::string> Ripe::signRSABatch(const std::vector<std::string>& data, const RSAPrivateKeyHandle& privateKey,
+                                            unsigned int threads, SignatureScheme scheme)
+{
+    return signMessages(data, threads, [&]() {
+        return createRSASigner(privateKey.m_impl->key, scheme);
+    });
+}
+
+namespace {
+
+// Ed25519 keys are stored as PKCS #8 / X.509 DER wrapped in PEM, same as OpenSSL
+std::string encodePEM(const std::string& der, const std::string& label)
+{
+    const std::size_t LINE_LENGTH = 64;
+    const std::string base64 = Ripe::base64Encode(der);
+    std::string pem = "-----BEGIN " + label + "-----\n";
+    for (std::size_t i = 0; i < base64.size(); i += LINE_LENGTH) {
+        pem.append(base64, i, LINE_LENGTH);
+        pem.push_back('\n');
+    }
+    pem += "-----END " + label + "-----\n";
+    return pem;
+}
+
+std::string decodePEM(const std::string& pem, const std::string& label)
+{
+    const std::string header = "-----BEGIN " + label + "-----";
+    const std::string footer = "-----END " + label + "-----";
+    const std::size_t start = pem.find(header);
+    const std::size_t end = start == std::string::npos ? std::string::npos : pem.find(footer, start);
+    if (end == std::string::npos) {
+        throw std::invalid_argument("Could not load key, expected PEM with " + label);
+    }
+    // Line breaks are skipped by the decoder
+    return Ripe::base64Decode(pem.substr(start + header.size(), end - start - header.size()));
+}
+
+#ifdef RIPE_HAS_ED25519
+std::unique_ptr<PK_Signer> createEd25519Signer(const std::string& privateKeyPEM, const std::string& secret)
+{
+    if (!secret.empty()) {
+        throw std::invalid_argument("Encrypted Ed25519 private keys are not supported");
+    }
+    StringSource source(decodePEM(privateKeyPEM, "PRIVATE KEY"), true);
+    return std::unique_ptr<PK_Signer>(new ed25519::Signer(source));
+}
+
+std::unique_ptr<PK_Verifier> createEd25519Verifier(const std::string& publicKeyPEM)
+{
+    StringSource source(decodePEM(publicKeyPEM, "PUBLIC KEY"), true);
+    return std::unique_ptr<PK_Verifier>(new ed25519::Verifier(source));
+}
+
+// Factories keep raw bytes of key that is decoded once so more signers (verifiers) are created without PEM
+std::function<std::unique_ptr<PK_Signer>()> createEd25519SignerFactory(const std::string& privateKeyPEM, const std::string& secret)
+{
+    const std::unique_ptr<PK_Signer> signer = createEd25519Signer(privateKeyPEM, secret);
+    const ed25519PrivateKey& key = dynamic_cast<const ed25519PrivateKey&>(signer->GetPrivateKey());
+    std::shared_ptr<SecByteBlock> bytes = std::make_shared<SecByteBlock>(ed25519PrivateKey::PUBLIC_KEYLENGTH + ed25519PrivateKey::SECRET_KEYLENGTH);
+    std::copy(key.GetPublicKeyBytePtr(), key.GetPublicKeyBytePtr() + ed25519PrivateKey::PUBLIC_KEYLENGTH, bytes->begin());
+    std::copy(key.GetPrivateKeyBytePtr(), key.GetPrivateKeyBytePtr() + ed25519PrivateKey::SECRET_KEYLENGTH,
+              bytes->begin() + ed25519PrivateKey::PUBLIC_KEYLENGTH);
+    return [bytes]() {
+        return std::unique_ptr<PK_Signer>(new ed25519::Signer(bytes->begin(), bytes->begin() + ed25519PrivateKey::PUBLIC_KEYLENGTH));
+    };
+}
+
+std::function<std::unique_ptr<PK_Verifier>()> createEd25519VerifierFactory(const std::string& publicKeyPEM)
+{
+    const std::unique_ptr<PK_Verifier> verifier = createEd25519Verifier(publicKeyPEM);
+    const ed25519PublicKey& key = dynamic_cast<const ed25519PublicKey&>(verifier->GetPublicKey());
+    std::shared_ptr<SecByteBlock> bytes = std::make_shared<SecByteBlock>(key.GetPublicKeyBytePtr(), ed25519PublicKey::PUBLIC_KEYLENGTH);
+    return [bytes]() {
+        return std::unique_ptr<PK_Verifier>(new ed25519::Verifier(bytes->begin()));
+    };
+}
+#else
+std::unique_ptr<PK_Signer> createEd25519Signer(const std::string&, const std::string&)
+{
+    throw std::invalid_argument("Ed25519 requires Crypto++ 8.0 or newer");
+}
+
+std::unique_ptr<PK_Verifier> createEd25519Verifier(const std::string&)
+{
+    throw std::invalid_argument("Ed25519 requires Crypto++ 8.0 or newer");
+}
+
+std::function<std::unique_ptr<PK_Signer>()> createEd25519SignerFactory(const std::string&, const std::string&)
+{
+    throw std::invalid_argument("Ed25519 requires Crypto++ 8.0 or newer");
+}
+
+std::function<std::unique_ptr<PK_Verifier>()> createEd25519VerifierFactory(const std::string&)
+{
+    throw std::invalid_argument("Ed25519 requires Crypto++ 8.0 or newer");
+}
+#endif
+
+} // namespace
+
+bool Ripe::isSignatureSchemeSupported(SignatureScheme scheme)
+{
+    switch (scheme) {
+    case SIGNATURE_RSA_PKCS1_SHA1:
+    case SIGNATURE_RSA_PSS_SHA256:
+        return true;
+    case SIGNATURE_ED25519:
+#ifdef RIPE_HAS_ED25519
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+std::string Ripe::sign(const std::string& data, const std::string& privateKeyPEM, SignatureScheme scheme, const std::string& secret)
+{
+    if (scheme == SIGNATURE_ED25519) {
+        return signMessage(*createEd25519Signer(privateKeyPEM, secret), data);
+    }
+    return Ripe::signRSA(data, RSAPrivateKeyHandle(privateKeyPEM, secret), scheme);
+}
+
+bool Ripe::verify(const std::string& data, const std::string& signatureHex, const std::string& publicKeyPEM, SignatureScheme scheme)
+{
+    if (scheme == SIGNATURE_ED25519) {
+        return verifySignature(*createEd25519Verifier(publicKeyPEM), data, signatureHex);
+    }
+    return Ripe::verifyRSA(data, signatureHex, RSAPublicKeyHandle(publicKeyPEM), scheme);
+}
+
+std::vector<std::string> Ripe::signBatch(const std::vector<std::string>& data, const std::string& privateKeyPEM, SignatureScheme scheme,
+                                         const std::string& secret, unsigned int threads)
+{
+    if (scheme == SIGNATURE_ED25519) {
+        return signMessages(data, threads, [&]() {
+            return createEd25519Signer(privateKeyPEM, secret);
+        });
+    }
+    return Ripe::signRSABatch(data, RSAPrivateKeyHandle(privateKeyPEM, secret), threads, scheme);
+}
+
+std::vector<bool> Ripe::verifyBatch(const std::vector<std::string>& data, const std::vector<std::string>& signaturesHex,
+                                    const std::string& publicKeyPEM, SignatureScheme scheme, unsigned int threads)
+{
+    if (scheme == SIGNATURE_ED25519) {
+        return verifyMessages(data, signaturesHex, threads, [&]() {
+            return createEd25519Verifier(publicKeyPEM);
+        });
+    }
+    return Ripe::verifyRSABatch(data, signaturesHex, RSAPublicKeyHandle(publicKeyPEM), threads, scheme);
+}
+
+struct Ripe::Signer::Impl
+{
+    SignatureScheme scheme;
+    // Creates signer from already parsed key, shared by copies
+    std::function<std::unique_ptr<PK_Signer>()> create;
+    std::unique_ptr<PK_Signer> signer;
+
+    Impl(SignatureScheme scheme, const std::function<std::unique_ptr<PK_Signer>()>& create) :
+        scheme(scheme),
+        create(create),
+        signer(create())
+    {
+    }
+};
+
+Ripe::Signer::Signer(const std::string& privateKeyPEM, SignatureScheme scheme, const std::string& secret)
+{
+    if (scheme == SIGNATURE_ED25519) {
+        m_impl.reset(new Impl(scheme, createEd25519SignerFactory(privateKeyPEM, secret)));
+        return;
+    }
+    const RSAPrivateKeyHandle key(privateKeyPEM, secret);
+    m_impl.reset(new Impl(scheme, [key, scheme]() {
+        return createRSASigner(key.m_impl->key, scheme);
+    }));
+}
+
+Ripe::Signer::Signer(const Signer& other) :
+    m_impl(new Impl(other.m_impl->scheme, other.m_impl->create))
+{
+}
+
+Ripe::Signer::Signer(Signer&&) = default;
+
+Ripe::Signer& Ripe::Signer::operator=(Signer&&) = default;
+
+Ripe::Signer::~Signer()
+{
+}
+
+std::string Ripe::Signer::sign(const std::string& data)
+{
+    return signMessage(*m_impl->signer, data);
+}
+
+Ripe::SignatureScheme Ripe::Signer::scheme() const
+{
+    return m_impl->scheme;
+}
+
+struct Ripe::Verifier::Impl
+{
+    SignatureScheme scheme;
+    std::function<std::unique_ptr<PK_Verifier>()> create;
+    std::unique_ptr<PK_Verifier> verifier;
+
+    Impl(SignatureScheme scheme, const std::function<std::unique_ptr<PK_Verifier>()>& create) :
+        scheme(scheme),
+        create(create),
+        verifier(create())
+    {
+    }
+};
+
+Ripe::Verifier::Verifier(const std::string& publicKeyPEM, SignatureScheme scheme)
+{
+    if (scheme == SIGNATURE_ED25519) {
+        m_impl.reset(new Impl(scheme, createEd25519VerifierFactory(publicKeyPEM)));
+        return;
+    }
+    const RSAPublicKeyHandle key(publicKeyPEM);
+    m_impl.reset(new Impl(scheme, [key, scheme]() {
+        return createRSAVerifier(key.m_impl->key, scheme);
+    }));
+}
+
+Ripe::Verifier::Verifier(const Verifier& other) :
+    m_impl(new Impl(other.m_impl->scheme, other.m_impl->create))
+{
+}
+
+Ripe::Verifier::Verifier(Verifier&&) = default;
+
+Ripe::Verifier& Ripe::Verifier::operator=(Verifier&&) = default;
+
+Ripe::Verifier::~Verifier()
+{
+}
+
+bool Ripe::Verifier::verify(const std::string& data, const std::string& signatureHex)
+{
+    return verifySignature(*m_impl->verifier, data, signatureHex);
+}
+
+Ripe::SignatureScheme Ripe::Verifier::scheme() const
+{
+    return m_impl->scheme;
+}
+
+namespace {
+
+void writeKeyPair(const Ripe::KeyPair& keypair, const std::string& publicFile, const std::string& privateFile)
+{
+    std::ofstream fs(privateFile.c_str(), std::ios::out);
+    if (!fs.is_open()) {
+        throw std::runtime_error(
+                    std::string("Unable to open private file for writing [" + privateFile + "] " + std::strerror(errno)).data()
+                    );
+    }
+    fs.write(keypair.privateKey.c_str(), keypair.privateKey.size());
+    fs.close();
+    fs.open(publicFile.c_str(), std::ios::out);
+    if (!fs.is_open()) {
+        throw std::runtime_error(
+                    std::string("Unable to open public file for writing [" + publicFile + "] " + std::strerror(errno)).data()
+                    );
+    }
+    fs.write(keypair.publicKey.c_str(), keypair.publicKey.size());
+    fs.close();
+}
+
+} // namespace
+
+Ripe::KeyPair Ripe::generateEd25519KeyPair()
+{
+#ifdef RIPE_HAS_ED25519
+    LibraryRandomNumberGenerator rng;
+    ed25519::Signer signer(rng);
+    ed25519::Verifier verifier(signer);
+
+    std::string privateDER;
+    std::string publicDER;
+    {
+        StringSink snk(privateDER);
+        signer.GetPrivateKey().Save(snk);
+        snk.MessageEnd();
+    }
+    {
+        StringSink snk(publicDER);
+        verifier.GetPublicKey().Save(snk);
+        snk.MessageEnd();
+    }
+    Ripe::KeyPair pair;
+    pair.privateKey = encodePEM(privateDER, "PRIVATE KEY");
+    pair.publicKey = encodePEM(publicDER, "PUBLIC KEY");
+    return pair;
+#else
+    throw std::invalid_argument("Ed25519 requires Crypto++ 8.0 or newer");
+#endif
+}
+
+bool Ripe::writeEd25519KeyPair(const std::string& publicFile, const std::string& privateFile)
+{
+    writeKeyPair(Ripe::generateEd25519KeyPair(), publicFile, privateFile);
+    return true;
+}
+
+bool Ripe::writeRSAKeyPair(const std::string& publicFile, const std::string& privateFile, int length, const std::string& secret)
+{
+    KeyPair keypair = Ripe::generateRSAKeyPair(length, secret);
+    if (keypair.privateKey.empty() || keypair.publicKey.empty()) {
+        throw std::runtime_error("Failed to generate key pair.");
+    }
+    writeKeyPair(keypair, publicFile, privateFile);
+    return true;
+}
+
+struct Ripe::KeyPairPool::Impl
+{
+    const unsigned int length;
+    const std::size_t targetDepth;
+    const std::string secret;
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable pairAdded;
+    std::deque<KeyPair> pairs;
+    std::size_t inProgress;
+    bool stopping;
+    std::vector<std::thread> workers;
+    Stats stats;
+
+    Impl(unsigned int len, std::size_t depth, const std::string& keySecret) :
+        length(len),
+        targetDepth(depth),
+        secret(keySecret),
+        inProgress(0),
+        stopping(false),
+        stats()
+    {
+        stats.targetDepth = targetDepth;
+    }
+
+    void run()
+    {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [&]() { return stopping || pairs.size() + inProgress < targetDepth; });
+                if (stopping) {
+                    return;
+                }
+                ++inProgress;
+            }
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            KeyPair pair;
+            bool failed = false;
+            try {
+                pair = Ripe::generateRSAKeyPair(length, secret);
+            } catch (const std::exception&) {
+                failed = true;
+            }
+            const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            --inProgress;
+            if (failed) {
+                // Same key parameters fail every time, stop this worker instead of spinning
+                ++stats.failures;
+                pairAdded.notify_all();
+                return;
+            }
+            pairs.push_back(std::move(pair));
+            stats.lastGenerationTime = elapsed;
+            stats.averageGenerationTime += (elapsed - stats.averageGenerationTime) / static_cast<double>(++stats.generated);
+            stats.maxGenerationTime = std::max(stats.maxGenerationTime, elapsed);
+            pairAdded.notify_all();
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+            it->join();
+        }
+        workers.clear();
+    }
+};
+
+Ripe::KeyPairPool::KeyPairPool(unsigned int length, std::size_t targetDepth, unsigned int threads, const std::string& secret) :
+    m_impl(new Impl(length, targetDepth, secret))
+{
+    threads = resolveThreadCount(threads);
+    try {
+        for (unsigned int i = 0; i < threads; ++i) {
+            m_impl->workers.emplace_back(&Impl::run, m_impl.get());
+        }
+    } catch (...) {
+        m_impl->stop();
+        throw;
+    }
+}
+
+Ripe::KeyPairPool::~KeyPairPool()
+{
+    m_impl->stop();
+}
+
+bool Ripe::KeyPairPool::acquire(KeyPair& pair)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        if (m_impl->pairs.empty()) {
+            ++m_impl->stats.misses;
+            return false;
+        }
+        pair = std::move(m_impl->pairs.front());
+        m_impl->pairs.pop_front();
+        ++m_impl->stats.acquired;
+    }
+    m_impl->workAvailable.notify_one();
+    return true;
+}
+
+Ripe::KeyPair Ripe::KeyPairPool::acquireOrGenerate()
+{
+    KeyPair pair;
+    if (!acquire(pair)) {
+        pair = Ripe::generateRSAKeyPair(m_impl->length, m_impl->secret);
+    }
+    return pair;
+}
+
+bool Ripe::KeyPairPool::waitForDepth(std::size_t depth, unsigned int timeoutMilliseconds)
+{
+    std::unique_lock<std::mutex> lock(m_impl->mutex);
+    return m_impl->pairAdded.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), [&]() {
+        return m_impl->pairs.size() >= depth || m_impl->stats.failures > 0;
+    }) && m_impl->pairs.size() >= depth;
+}
+
+std::size_t Ripe::KeyPairPool::depth() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    return m_impl->pairs.size();
+}
+
+Ripe::KeyPairPool::Stats Ripe::KeyPairPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    Stats result = m_impl->stats;
+    result.depth = m_impl->pairs.size();
+    return result;
+}
+
+namespace {
+
+// Executor (and worker index) of current thread, tasks posted from a worker go to its own queue
+thread_local const void* executorOfThread = nullptr;
+thread_local std::size_t workerOfThread = 0;
+
+// Most light tasks taken (or stolen) from an executor queue at once
+const std::size_t EXECUTOR_BATCH_SIZE = 32;
+
+} // namespace
+
+struct Ripe::Executor::Impl
+{
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    const unsigned int heavyLimit;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<std::size_t> nextQueue;
+
+    // Light tasks in worker queues and workers waiting for work, sleeping workers are only
+    // notified when there are any
+    std::atomic<std::size_t> pendingLight;
+    std::atomic<std::size_t> sleeping;
+
+    // Guards heavy tasks, heavyRunning and stopping
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::deque<Task> heavy;
+    std::atomic<std::size_t> pendingHeavy;
+    unsigned int heavyRunning;
+    bool stopping;
+    std::vector<std::thread> workers;
+
+    Impl(unsigned int threads, unsigned int heavyThreads) :
+        heavyLimit(threads == 1 ? 1 : std::min(heavyThreads == 0 ? std::max(threads / 2, 1U) : heavyThreads, threads - 1)),
+        nextQueue(0),
+        pendingLight(0),
+        sleeping(0),
+        pendingHeavy(0),
+        heavyRunning(0),
+        stopping(false)
+    {
+        for (unsigned int i = 0; i < threads; ++i) {
+            queues.emplace_back(new Queue());
+        }
+    }
+
+    void post(Task&& task, TaskWeight weight)
+    {
+        if (weight == TASK_HEAVY) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                heavy.push_back(std::move(task));
+                ++pendingHeavy;
+            }
+            workAvailable.notify_one();
+            return;
+        }
+        const std::size_t index = executorOfThread == this ? workerOfThread : nextQueue++ % queues.size();
+        {
+            // Counted under queue lock so it is never decremented by a thief first
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+            ++pendingLight;
+        }
+        // Sleeper either sees pendingLight before it waits or is notified here (both are sequentially consistent)
+        if (sleeping > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            workAvailable.notify_one();
+        }
+    }
+
+    // Takes light tasks from front of own queue or steals half of other queue from its back
+    bool takeLight(std::size_t worker, std::vector<Task>& batch)
+    {
+        for (std::size_t i = 0; i < queues.size(); ++i) {
+            const bool own = i == 0;
+            Queue& queue = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            const std::size_t count = std::min(own ? queue.tasks.size() : (queue.tasks.size() + 1) / 2, EXECUTOR_BATCH_SIZE);
+            if (own) {
+                std::move(queue.tasks.begin(), queue.tasks.begin() + count, std::back_inserter(batch));
+                queue.tasks.erase(queue.tasks.begin(), queue.tasks.begin() + count);
+            } else {
+                std::move(queue.tasks.end() - count, queue.tasks.end(), std::back_inserter(batch));
+                queue.tasks.erase(queue.tasks.end() - count, queue.tasks.end());
+            }
+            pendingLight -= count;
+            return true;
+        }
+        return false;
+    }
+
+    // Takes heavy task if there is one and heavy limit is not reached, mutex must be held
+    bool takeHeavy(Task& task)
+    {
+        if (heavy.empty() || heavyRunning >= heavyLimit) {
+            return false;
+        }
+        task = std::move(heavy.front());
+        heavy.pop_front();
+        --pendingHeavy;
+        ++heavyRunning;
+        return true;
+    }
+
+    static void run(Task& task)
+    {
+        try {
+            task();
+        } catch (...) {
+            // Tasks that need their errors use submit
+        }
+        task = nullptr;
+    }
+
+    void work(std::size_t worker)
+    {
+        executorOfThread = this;
+        workerOfThread = worker;
+        std::vector<Task> batch;
+        batch.reserve(EXECUTOR_BATCH_SIZE);
+        Task task;
+        for (;;) {
+            // Heavy tasks are checked first so they are not starved by constant light load, heavy
+            // limit keeps other workers for light tasks
+            if (pendingHeavy > 0) {
+                bool taken;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    taken = takeHeavy(task);
+                }
+                if (taken) {
+                    run(task);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --heavyRunning;
+                    if (!heavy.empty() || stopping) {
+                        workAvailable.notify_all();
+                    }
+                    continue;
+                }
+            }
+            if (takeLight(worker, batch)) {
+                for (std::vector<Task>::iterator it = batch.begin(); it != batch.end(); ++it) {
+                    run(*it);
+                }
+                batch.clear();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            ++sleeping;
+            workAvailable.wait(lock, [&]() {
+                return pendingLight > 0 || (!heavy.empty() && heavyRunning < heavyLimit)
+                        || (stopping && heavy.empty() && heavyRunning == 0);
+            });
+            --sleeping;
+            if (stopping && pendingLight == 0 && heavy.empty() && heavyRunning == 0) {
+                return;
+            }
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+            it->join();
+        }
+        workers.clear();
+    }
+};
+
+Ripe::Executor::Executor(unsigned int threads, unsigned int heavyThreads) :
+    m_impl(new Impl(resolveThreadCount(threads), heavyThreads))
+{
+    try {
+        for (std::size_t i = 0; i < m_impl->queues.size(); ++i) {
+            m_impl->workers.emplace_back(&Impl::work, m_impl.get(), i);
+        }
+    } catch (...) {
+        m_impl->stop();
+        throw;
+    }
+}
+
+Ripe::Executor::~Executor()
+{
+    m_impl->stop();
+}
+
+void Ripe::Executor::post(Task task, TaskWeight weight)
+{
+    m_impl->post(std::move(task), weight);
+}
+
+unsigned int Ripe::Executor::threads() const
+{
+    return static_cast<unsigned int>(m_impl->queues.size());
+}
+
+std::future<Ripe::KeyPair> Ripe::Executor::generateRSAKeyPair(unsigned int length, const std::string& secret)
+{
+    return submit([length, secret]() { return Ripe::generateRSAKeyPair(length, secret); }, TASK_HEAVY);
+}
+
+std::future<std::string> Ripe::Executor::decryptRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey)
+{
+    return submit([data, privateKey]() { return Ripe::decryptRSA(data, privateKey); }, TASK_HEAVY);
+}
+
+std::future<std::string> Ripe::Executor::signRSA(const std::string& data, const RSAPrivateKeyHandle& privateKey, SignatureScheme scheme)
+{
+    return submit([data, privateKey, scheme]() { return Ripe::signRSA(data, privateKey, scheme); }, TASK_HEAVY);
+}
+
+std::future<bool> Ripe::Executor::compressFile(const std::string& gzFilename, const std::string& inputFile, int level)
+{
+    // Single thread, compressing on all cores would take every core from other tasks
+    return submit([gzFilename, inputFile, level]() { return Ripe::compressFile(gzFilename, inputFile, 1, level); }, TASK_HEAVY);
+}
+
+std::future<bool> Ripe::Executor::decompressFile(const std::string& gzFilename, const std::string& outputFile)
+{
+    return submit([gzFilename, outputFile]() { return Ripe::decompressFile(gzFilename, outputFile); }, TASK_HEAVY);
+}
+
+std::string Ripe::generateRSAKeyPairBase64(int length, const std::string& secret)
+{
+    Ripe::KeyPair pair = Ripe::generateRSAKeyPair(length, secret);
+    if (pair.privateKey.empty() || pair.publicKey.empty()) {
+        throw std::runtime_error("Failed to generate key pair.");
+    }
+    return Ripe::base64Encode(pair.privateKey) + ":" + Ripe::base64Encode(pair.publicKey);
+}
+
+Ripe::KeyPair Ripe::generateRSAKeyPair(unsigned int length, const std::string& secret)
+{
+    RIPE_STATS_SCOPE(STATS_RSA_GENERATE_KEY, 0);
+    LibraryRandomNumberGenerator rng;
+    InvertibleRSAFunction params;
+    params.GenerateRandomWithKeySize(rng, length);
+    RSA::PrivateKey privateKey(params);
+    RSA::PublicKey publicKey(params);
+
+    Ripe::KeyPair pair;
+    {
+        StringSink snk(pair.privateKey);
+        if (secret.empty()) {
+            PEM_Save(snk, privateKey);
+        } else {
+            PEM_Save(snk, privateKey, rng, PRIVATE_RSA_ALGORITHM, secret.data(), secret.size());
+        }
+        snk.MessageEnd();
+    }
+    {
+        StringSink snk(pair.publicKey);
+        PEM_Save(snk, publicKey);
+        snk.MessageEnd();
+    }
+    return pair;
+}
+
+std::string Ripe::base64Encode(const std::string& input)
+{
+    std::string encoded(Ripe::expectedBase64Length(input.size()), '\0');
+    encoded.resize(Ripe::base64Encode(reinterpret_cast<const RipeByte*>(input.data()), input.size(),
+                                      reinterpret_cast<RipeByte*>(&encoded[0]), encoded.size()));
+    return encoded;
+}
+
+std::size_t Ripe::base64Encode(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap)
+{
+    RIPE_STATS_SCOPE(STATS_BASE64_ENCODE, n);
+    if (outCap < Ripe::expectedBase64Length(n)) {
+        throw std::invalid_argument("Output buffer too small for base64 encoding");
+    }
+    return RipeCodec::base64Encode(in, n, out);
+}
+
+std::string Ripe::base64Decode(const std::string& base64Encoded)
+{
+    std::string decoded(Ripe::maxBase64DecodedLength(base64Encoded.size()), '\0');
+    decoded.resize(Ripe::base64Decode(reinterpret_cast<const RipeByte*>(base64Encoded.data()), base64Encoded.size(),
+                                      reinterpret_cast<RipeByte*>(&decoded[0]), decoded.size()));
+    return decoded;
+}
+
+std::size_t Ripe::base64Decode(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap)
+{
+    RIPE_STATS_SCOPE(STATS_BASE64_DECODE, n);
+    if (outCap < Ripe::maxBase64DecodedLength(n)) {
+        throw std::invalid_argument("Output buffer too small for base64 decoding");
+    }
+    return RipeCodec::base64Decode(in, n, out);
+}
+
+std::string Ripe::generateNewKey(int length)
+{
+    if (!(length == 16 || length == 24 || length == 32)) {
+        throw std::invalid_argument( "Invalid key length. Acceptable lengths are 16, 24 or 32" );
+    }
+    SecByteBlock key(length);
+    Ripe::generateRandom(key.data(), key.size());
+    std::string s;
+    HexEncoder hex(new StringSink(s));
+    hex.Put(key.data(), key.size());
+    hex.MessageEnd();
+    return s;
+}
+
+namespace {
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+void validateAESKeySize(std::size_t keySize)
+{
+    if (!(keySize == 16 || keySize == 24 || keySize == 32)) {
+        throw std::invalid_argument("Invalid key length. Acceptable lengths are 16, 24 or 32");
+    }
+}
+
+} // namespace
+
+struct Ripe::AESContext::Impl
+{
+    SecByteBlock key;
+
+    void init(const RipeByte* k, std::size_t keySize)
+    {
+        validateAESKeySize(keySize);
+        key.Assign(k, keySize);
+    }
+
+    // Key schedule (and GCM tables) of a mode is computed on first use of that mode, every message
+    // only resynchronizes IV. Short-lived contexts that use one mode only pay for one key setup
+    CBC_Mode<AES>::Encryption& encryption()
+    {
+        return keyed(m_encryption, m_hasEncryption, Ripe::AES_BLOCK_SIZE);
+    }
+
+    CBC_Mode<AES>::Decryption& decryption()
+    {
+        return keyed(m_decryption, m_hasDecryption, Ripe::AES_BLOCK_SIZE);
+    }
+
+    GCM<AES>::Encryption& gcmEncryption()
+    {
+        return keyed(m_gcmEncryption, m_hasGCMEncryption, Ripe::AES_GCM_IV_SIZE);
+    }
+
+    GCM<AES>::Decryption& gcmDecryption()
+    {
+        return keyed(m_gcmDecryption, m_hasGCMDecryption, Ripe::AES_GCM_IV_SIZE);
+    }
+
+    CTR_Mode<AES>::Encryption& ctr()
+    {
+        return keyed(m_ctr, m_hasCTR, Ripe::AES_BLOCK_SIZE);
+    }
+
+    static void toIvBlock(const std::vector<RipeByte>& iv, RipeByte* ivArr)
+    {
+        if (iv.size() != static_cast<std::size_t>(Ripe::AES_BLOCK_SIZE)) {
+            throw std::invalid_argument("Invalid IV");
+        }
+        std::copy(iv.begin(), iv.end(), ivArr);
+    }
+
+private:
+    CBC_Mode<AES>::Encryption m_encryption;
+    CBC_Mode<AES>::Decryption m_decryption;
+    GCM<AES>::Encryption m_gcmEncryption;
+    GCM<AES>::Decryption m_gcmDecryption;
+    CTR_Mode<AES>::Encryption m_ctr;
+    bool m_hasEncryption = false;
+    bool m_hasDecryption = false;
+    bool m_hasGCMEncryption = false;
+    bool m_hasGCMDecryption = false;
+    bool m_hasCTR = false;
+
+    template <class Mode>
+    Mode& keyed(Mode& mode, bool& hasKey, int ivSize)
+    {
+        if (!hasKey) {
+            RIPE_STATS_SCOPE(STATS_AES_KEY_SETUP, key.size());
+            const RipeByte zeroIv[Ripe::AES_BLOCK_SIZE] = {0};
+            mode.SetKeyWithIV(key, key.size(), zeroIv, ivSize);
+            hasKey = true;
+        }
+        return mode;
+    }
+};
+
+Ripe::AESContext::AESContext(const RipeByte* key, std::size_t keySize) :
+    m_impl(new Impl)
+{
+    m_impl->init(key, keySize);
+}
+
+Ripe::AESContext::AESContext(const std::string& hexKey) :
+    m_impl(new Impl)
+{
+    // Decoded key is wiped once key schedule is ready
+    ScratchBuffer key(hexKey.size() / 2, true);
+    key.resize(Ripe::hexToString(reinterpret_cast<const RipeByte*>(hexKey.data()), hexKey.size(), key.data(), key.size()));
+    m_impl->init(key.data(), key.size());
+}
+
+Ripe::AESContext::AESContext(AESContext&&) = default;
+
+Ripe::AESContext& Ripe::AESContext::operator=(AESContext&&) = default;
+
+Ripe::AESContext::~AESContext()
+{
+}
+
+std::size_t Ripe::AESContext::keySize() const
+{
+    return m_impl->key.size();
+}
+
+std::string Ripe::AESContext::encrypt(const std::string& data, std::vector<RipeByte>& iv)
+{
+    RipeByte ivArr[Ripe::AES_BLOCK_SIZE] = {0};
+
+    if (iv.empty()) {
+        generateRandom(ivArr, sizeof ivArr);
+        // store for user
+        iv.assign(ivArr, ivArr + Ripe::AES_BLOCK_SIZE);
+    } else {
+        Impl::toIvBlock(iv, ivArr);
+    }
+
+    std::string cipher(Ripe::expectedAESCipherLength(data.size()), '\0');
+    encrypt(reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+            reinterpret_cast<RipeByte*>(&cipher[0]), cipher.size(), ivArr);
+    return cipher;
+}
+
+std::string Ripe::AESContext::encrypt(const std::string& data, const AESIV& iv)
+{
+    std::string cipher(Ripe::expectedAESCipherLength(data.size()), '\0');
+    encrypt(reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+            reinterpret_cast<RipeByte*>(&cipher[0]), cipher.size(), iv.data());
+    return cipher;
+}
+
+std::size_t Ripe::AESContext::encrypt(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv)
+{
+    RIPE_STATS_SCOPE(STATS_AES_ENCRYPT, n);
+    const std::size_t cipherLength = Ripe::expectedAESCipherLength(n);
+    if (outCap < cipherLength) {
+        throw std::invalid_argument("Output buffer too small for AES cipher");
+    }
+
+    CBC_Mode<AES>::Encryption& encryption = m_impl->encryption();
+    encryption.Resynchronize(iv, Ripe::AES_BLOCK_SIZE);
+
+    const std::size_t fullBlocksSize = n - (n % Ripe::AES_BLOCK_SIZE);
+
+    // PKCS #7 padding for last block (same as StreamTransformationFilter)
+    // we copy it before processing full blocks as input and output may overlap
+    RipeByte lastBlock[Ripe::AES_BLOCK_SIZE];
+    const std::size_t remaining = n - fullBlocksSize;
+    std::copy(in + fullBlocksSize, in + n, lastBlock);
+    std::fill(lastBlock + remaining, lastBlock + Ripe::AES_BLOCK_SIZE, static_cast<RipeByte>(Ripe::AES_BLOCK_SIZE - remaining));
+
+    encryption.ProcessData(out, in, fullBlocksSize);
+    encryption.ProcessData(out + fullBlocksSize, lastBlock, Ripe::AES_BLOCK_SIZE);
+    return cipherLength;
+}
+
+std::string Ripe::AESContext::decrypt(const std::string& data, const std::vector<RipeByte>& iv)
+{
+    RipeByte ivArr[Ripe::AES_BLOCK_SIZE] = {0};
+    Impl::toIvBlock(iv, ivArr);
+
+    std::string result(data.size(), '\0');
+    result.resize(decrypt(reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+                          reinterpret_cast<RipeByte*>(&result[0]), result.size(), ivArr));
+    return result;
+}
+
+std::string Ripe::AESContext::decrypt(const std::string& data, const AESIV& iv)
+{
+    std::string result(data.size(), '\0');
+    result.resize(decrypt(reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+                          reinterpret_cast<RipeByte*>(&result[0]), result.size(), iv.data()));
+    return result;
+}
+
+std::size_t Ripe::AESContext::decrypt(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv)
+{
+    RIPE_STATS_SCOPE(STATS_AES_DECRYPT, n);
+    if (n == 0 || n % Ripe::AES_BLOCK_SIZE != 0) {
+        throw InvalidCiphertext("StreamTransformationFilter: ciphertext length is not a multiple of block size");
+    }
+    if (outCap < n) {
+        throw std::invalid_argument("Output buffer too small for AES plain data");
+    }
+
+    CBC_Mode<AES>::Decryption& decryption = m_impl->decryption();
+    decryption.Resynchronize(iv, Ripe::AES_BLOCK_SIZE);
+    decryption.ProcessData(out, in, n);
+
+    const std::size_t padding = out[n - 1];
+    bool validPadding = padding > 0 && padding <= static_cast<std::size_t>(Ripe::AES_BLOCK_SIZE);
+    for (std::size_t i = 1; validPadding && i <= padding; ++i) {
+        validPadding = out[n - i] == padding;
+    }
+    if (!validPadding) {
+        throw InvalidCiphertext("StreamTransformationFilter: invalid PKCS #7 block padding found");
+    }
+    return n - padding;
+}
+
+std::size_t Ripe::AESContext::encryptGCM(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv,
+                                         const RipeByte* additionalData, std::size_t additionalDataSize)
+{
+    RIPE_STATS_SCOPE(STATS_AES_GCM_ENCRYPT, n);
+    const std::size_t cipherLength = Ripe::expectedAESGCMCipherLength(n);
+    if (outCap < cipherLength) {
+        throw std::invalid_argument("Output buffer too small for AES-GCM cipher");
+    }
+    m_impl->gcmEncryption().EncryptAndAuthenticate(out, out + n, Ripe::AES_GCM_TAG_SIZE, iv, Ripe::AES_GCM_IV_SIZE,
+                                                 additionalData, additionalDataSize, in, n);
+    return cipherLength;
+}
+
+std::size_t Ripe::AESContext::decryptGCM(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv,
+                                         const RipeByte* additionalData, std::size_t additionalDataSize)
+{
+    RIPE_STATS_SCOPE(STATS_AES_GCM_DECRYPT, n);
+    if (n < static_cast<std::size_t>(Ripe::AES_GCM_TAG_SIZE)) {
+        throw InvalidCiphertext("AES-GCM: cipher is too short");
+    }
+    const std::size_t plainLength = n - Ripe::AES_GCM_TAG_SIZE;
+    if (outCap < plainLength) {
+        throw std::invalid_argument("Output buffer too small for AES-GCM plain data");
+    }
+    bool valid = m_impl->gcmDecryption().DecryptAndVerify(out, in + plainLength, Ripe::AES_GCM_TAG_SIZE, iv, Ripe::AES_GCM_IV_SIZE,
+                                                        additionalData, additionalDataSize, in, plainLength);
+    if (!valid) {
+        std::fill(out, out + plainLength, 0);
+        throw InvalidCiphertext("AES-GCM: message authentication failed");
+    }
+    return plainLength;
+}
+
+std::size_t Ripe::AESContext::processCTR(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap, const RipeByte* iv)
+{
+    if (outCap < n) {
+        throw std::invalid_argument("Output buffer too small for AES-CTR");
+    }
+    CTR_Mode<AES>::Encryption& ctr = m_impl->ctr();
+    ctr.Resynchronize(iv, Ripe::AES_BLOCK_SIZE);
+    ctr.ProcessData(out, in, n);
+    return n;
+}
+
+struct Ripe::AESStream::Impl
+{
+    Direction direction;
+    CBC_Mode<AES>::Encryption encryption;
+    CBC_Mode<AES>::Decryption decryption;
+    // Pending bytes that do not make a full block yet. When decrypting
+    // last full block is held back until final() as it contains padding
+    RipeByte pending[Ripe::AES_BLOCK_SIZE];
+    std::size_t pendingSize;
+    bool initialized;
+
+    Impl() :
+        direction(ENCRYPT),
+        pendingSize(0),
+        initialized(false)
+    {
+    }
+
+    void process(RipeByte* out, const RipeByte* in, std::size_t n)
+    {
+        if (direction == ENCRYPT) {
+            encryption.ProcessData(out, in, n);
+        } else {
+            decryption.ProcessData(out, in, n);
+        }
+    }
+};
+
+Ripe::AESStream::AESStream() :
+    m_impl(new Impl)
+{
+}
+
+Ripe::AESStream::AESStream(AESStream&&) = default;
+
+Ripe::AESStream& Ripe::AESStream::operator=(AESStream&&) = default;
+
+Ripe::AESStream::~AESStream()
+{
+}
+
+void Ripe::AESStream::init(Direction direction, const RipeByte* key, std::size_t keySize, const RipeByte* iv)
+{
+    validateAESKeySize(keySize);
+    m_impl->direction = direction;
+    if (direction == ENCRYPT) {
+        m_impl->encryption.SetKeyWithIV(key, keySize, iv);
+    } else {
+        m_impl->decryption.SetKeyWithIV(key, keySize, iv);
+    }
+    m_impl->pendingSize = 0;
+    m_impl->initialized = true;
+}
+
+std::size_t Ripe::AESStream::update(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap)
+{
+    if (!m_impl->initialized) {
+        throw std::logic_error("AES stream is not initialized");
+    }
+    if (outCap < n + Ripe::AES_BLOCK_SIZE) {
+        throw std::invalid_argument("Output buffer too small for AES stream");
+    }
+    const bool holdBack = m_impl->direction == DECRYPT;
+    std::size_t written = 0;
+    if (m_impl->pendingSize > 0) {
+        const std::size_t take = std::min(Ripe::AES_BLOCK_SIZE - m_impl->pendingSize, n);
+        std::copy(in, in + take, m_impl->pending + m_impl->pendingSize);
+        m_impl->pendingSize += take;
+        in += take;
+        n -= take;
+        if (m_impl->pendingSize == static_cast<std::size_t>(Ripe::AES_BLOCK_SIZE) && (!holdBack || n > 0)) {
+            m_impl->process(out, m_impl->pending, Ripe::AES_BLOCK_SIZE);
+            written += Ripe::AES_BLOCK_SIZE;
+            m_impl->pendingSize = 0;
+        }
+    }
+    if (n > 0) {
+        std::size_t fullBlocksSize = n - (n % Ripe::AES_BLOCK_SIZE);
+        if (holdBack && fullBlocksSize == n) {
+            fullBlocksSize -= Ripe::AES_BLOCK_SIZE;
+        }
+        m_impl->process(out + written, in, fullBlocksSize);
+        written += fullBlocksSize;
+        std::copy(in + fullBlocksSize, in + n, m_impl->pending);
+        m_impl->pendingSize = n - fullBlocksSize;
+    }
+    return written;
+}
+
+void Ripe::AESStream::update(const std::string& chunk, std::string& output)
+{
+    const std::size_t start = output.size();
+    output.resize(start + chunk.size() + Ripe::AES_BLOCK_SIZE);
+    std::size_t written = update(reinterpret_cast<const RipeByte*>(chunk.data()), chunk.size(),
+                                 reinterpret_cast<RipeByte*>(&output[start]), chunk.size() + Ripe::AES_BLOCK_SIZE);
+    output.resize(start + written);
+}
+
+std::size_t Ripe::AESStream::final(RipeByte* out, std::size_t outCap)
+{
+    if (!m_impl->initialized) {
+        throw std::logic_error("AES stream is not initialized");
+    }
+    if (outCap < static_cast<std::size_t>(Ripe::AES_BLOCK_SIZE)) {
+        throw std::invalid_argument("Output buffer too small for AES stream");
+    }
+    m_impl->initialized = false;
+    if (m_impl->direction == ENCRYPT) {
+        // PKCS #7 padding
+        std::fill(m_impl->pending + m_impl->pendingSize, m_impl->pending + Ripe::AES_BLOCK_SIZE,
+                  static_cast<RipeByte>(Ripe::AES_BLOCK_SIZE - m_impl->pendingSize));
+        m_impl->process(out, m_impl->pending, Ripe::AES_BLOCK_SIZE);
+        return Ripe::AES_BLOCK_SIZE;
+    }
+    if (m_impl->pendingSize != static_cast<std::size_t>(Ripe::AES_BLOCK_SIZE)) {
+        throw InvalidCiphertext("StreamTransformationFilter: ciphertext length is not a multiple of block size");
+    }
+    m_impl->process(out, m_impl->pending, Ripe::AES_BLOCK_SIZE);
+    const std::size_t padding = out[Ripe::AES_BLOCK_SIZE - 1];
+    bool validPadding = padding > 0 && padding <= static_cast<std::size_t>(Ripe::AES_BLOCK_SIZE);
+    for (std::size_t i = 1; validPadding && i <= padding; ++i) {
+        validPadding = out[Ripe::AES_BLOCK_SIZE - i] == padding;
+    }
+    if (!validPadding) {
+        throw InvalidCiphertext("StreamTransformationFilter: invalid PKCS #7 block padding found");
+    }
+    return Ripe::AES_BLOCK_SIZE - padding;
+}
+
+void Ripe::AESStream::final(std::string& output)
+{
+    const std::size_t start = output.size();
+    output.resize(start + Ripe::AES_BLOCK_SIZE);
+    output.resize(start + final(reinterpret_cast<RipeByte*>(&output[start]), Ripe::AES_BLOCK_SIZE));
+}
+
+namespace {
+
+std::size_t processAESStream(Ripe::AESStream::Direction direction, std::istream& in, std::ostream& out,
+                             const RipeByte* key, std::size_t keySize, const RipeByte* iv)
+{
+    Ripe::AESStream stream;
+    stream.init(direction, key, keySize, iv);
+    std::vector<RipeByte> inBuffer(Ripe::STREAM_CHUNK_SIZE);
+    std::vector<RipeByte> outBuffer(Ripe::STREAM_CHUNK_SIZE + Ripe::AES_BLOCK_SIZE);
+    std::size_t total = 0;
+    while (in) {
+        in.read(reinterpret_cast<char*>(inBuffer.data()), inBuffer.size());
+        std::size_t nRead = static_cast<std::size_t>(in.gcount());
+        if (nRead == 0) {
+            break;
+        }
+        std::size_t written = stream.update(inBuffer.data(), nRead, outBuffer.data(), outBuffer.size());
+        out.write(reinterpret_cast<const char*>(outBuffer.data()), written);
+        total += written;
+    }
+    if (in.bad()) {
+        throw std::runtime_error("Failed to read input stream");
+    }
+    std::size_t written = stream.final(outBuffer.data(), outBuffer.size());
+    out.write(reinterpret_cast<const char*>(outBuffer.data()), written);
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Failed to write output stream");
+    }
+    return total + written;
+}
+
+} // namespace
+
+std::size_t Ripe::encryptAES(std::istream& in, std::ostream& out, const RipeByte* key, std::size_t keySize, const RipeByte* iv)
+{
+    return processAESStream(AESStream::ENCRYPT, in, out, key, keySize, iv);
+}
+
+std::size_t Ripe::decryptAES(std::istream& in, std::ostream& out, const RipeByte* key, std::size_t keySize, const RipeByte* iv)
+{
+    return processAESStream(AESStream::DECRYPT, in, out, key, keySize, iv);
+}
+
+std::string Ripe::encryptAESGCM(const std::string& data, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv,
+                                const std::string& additionalData)
+{
+    if (iv.empty()) {
+        iv.resize(Ripe::AES_GCM_IV_SIZE);
+        generateRandom(iv.data(), iv.size());
+    } else if (iv.size() != static_cast<std::size_t>(Ripe::AES_GCM_IV_SIZE)) {
+        throw std::invalid_argument("Invalid IV length for AES-GCM");
+    }
+    std::string cipher(Ripe::expectedAESGCMCipherLength(data.size()), '\0');
+    AESContext(key, keySize).encryptGCM(reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+                                        reinterpret_cast<RipeByte*>(&cipher[0]), cipher.size(), iv.data(),
+                                        reinterpret_cast<const RipeByte*>(additionalData.data()), additionalData.size());
+    return cipher;
+}
+
+std::string Ripe::decryptAESGCM(const std::string& data, const RipeByte* key, std::size_t keySize, const std::vector<RipeByte>& iv,
+                                const std::string& additionalData)
+{
+    if (iv.size() != static_cast<std::size_t>(Ripe::AES_GCM_IV_SIZE)) {
+        throw std::invalid_argument("Invalid IV length for AES-GCM");
+    }
+    if (data.size() < static_cast<std::size_t>(Ripe::AES_GCM_TAG_SIZE)) {
+        throw InvalidCiphertext("AES-GCM: cipher is too short");
+    }
+    std::string result(data.size() - Ripe::AES_GCM_TAG_SIZE, '\0');
+    AESContext(key, keySize).decryptGCM(reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+                                        reinterpret_cast<RipeByte*>(&result[0]), result.size(), iv.data(),
+                                        reinterpret_cast<const RipeByte*>(additionalData.data()), additionalData.size());
+    return result;
+}
+
+std::string Ripe::encryptAESCTR(const std::string& data, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv)
+{
+    if (iv.empty()) {
+        iv.resize(Ripe::AES_BLOCK_SIZE);
+        generateRandom(iv.data(), iv.size());
+    }
+    return Ripe::decryptAESCTR(data, key, keySize, iv);
+}
+
+std::string Ripe::decryptAESCTR(const std::string& data, const RipeByte* key, std::size_t keySize, const std::vector<RipeByte>& iv)
+{
+    RipeByte ivArr[Ripe::AES_BLOCK_SIZE];
+    AESContext::Impl::toIvBlock(iv, ivArr);
+    std::string result(data.size(), '\0');
+    AESContext(key, keySize).processCTR(reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+                                        reinterpret_cast<RipeByte*>(&result[0]), result.size(), ivArr);
+    return result;
+}
+
+namespace {
+
+void writeBigEndian(RipeByte* out, std::uint64_t value, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        out[size - 1 - i] = static_cast<RipeByte>(value >> (8 * i));
+    }
+}
+
+std::uint64_t readBigEndian(const RipeByte* in, std::size_t size)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+// Header of chunked AES container
+// "RIPC" [version:1] [mode:1] [reserved:2] [segmentSize:4] [plainSize:8] [IVs...] [ciphers...]
+struct ChunkedAESHeader
+{
+    static const std::size_t SIZE = 20;
+    static const RipeByte VERSION = 1;
+
+    Ripe::AESMode mode;
+    std::size_t segmentSize;
+    std::uint64_t plainSize;
+    RipeByte bytes[SIZE];
+
+    ChunkedAESHeader(Ripe::AESMode m, std::size_t segSize, std::uint64_t size) :
+        mode(m),
+        segmentSize(segSize),
+        plainSize(size)
+    {
+        if (mode != Ripe::AES_GCM && mode != Ripe::AES_CBC) {
+            throw std::invalid_argument("Chunked AES only supports AES_GCM and AES_CBC");
+        }
+        // Segment size of forged header must not make decryption allocate huge buffers
+        if (segmentSize == 0 || segmentSize > 64 * Ripe::AES_SEGMENT_SIZE) {
+            throw std::invalid_argument("Invalid segment size");
+        }
+        std::copy(CHUNKED_MAGIC, CHUNKED_MAGIC + 4, bytes);
+        bytes[4] = VERSION;
+        bytes[5] = static_cast<RipeByte>(mode);
+        bytes[6] = bytes[7] = 0;
+        writeBigEndian(bytes + 8, segmentSize, 4);
+        writeBigEndian(bytes + 12, plainSize, 8);
+    }
+
+    static ChunkedAESHeader read(const RipeByte* in, std::size_t n)
+    {
+        if (n < SIZE || !std::equal(CHUNKED_MAGIC, CHUNKED_MAGIC + 4, in)) {
+            throw std::invalid_argument("Data is not chunked AES cipher");
+        }
+        if (in[4] != VERSION) {
+            throw std::invalid_argument("Unsupported chunked AES version");
+        }
+        return ChunkedAESHeader(static_cast<Ripe::AESMode>(in[5]),
+                                static_cast<std::size_t>(readBigEndian(in + 8, 4)),
+                                readBigEndian(in + 12, 8));
+    }
+
+    std::size_t ivSize() const
+    {
+        return mode == Ripe::AES_GCM ? Ripe::AES_GCM_IV_SIZE : Ripe::AES_BLOCK_SIZE;
+    }
+
+    std::size_t segmentCount() const
+    {
+        // Empty data still has one (empty) segment so it is encrypted (and authenticated)
+        return plainSize == 0 ? 1 : static_cast<std::size_t>((plainSize + segmentSize - 1) / segmentSize);
+    }
+
+    std::size_t plainLength(std::size_t segment) const
+    {
+        return static_cast<std::size_t>(std::min<std::uint64_t>(segmentSize, plainSize - static_cast<std::uint64_t>(segment) * segmentSize));
+    }
+
+    std::size_t cipherLength(std::size_t plainLen) const
+    {
+        return mode == Ripe::AES_GCM ? Ripe::expectedAESGCMCipherLength(plainLen) : Ripe::expectedAESCipherLength(plainLen);
+    }
+
+    // First segment is the largest, smaller than segmentSize when all data fits in one segment. Buffers are
+    // sized by it (and not segmentSize from header) so they are never larger than the data
+    std::size_t maxPlainLength() const
+    {
+        return plainLength(0);
+    }
+
+    std::size_t dataOffset() const
+    {
+        return SIZE + segmentCount() * ivSize();
+    }
+
+    std::uint64_t totalSize() const
+    {
+        const std::size_t count = segmentCount();
+        return dataOffset() + static_cast<std::uint64_t>(count - 1) * cipherLength(segmentSize) + cipherLength(plainLength(count - 1));
+    }
+
+    std::size_t process(bool encrypt, Ripe::AESContext& context, std::size_t segment, const RipeByte* iv,
+                        const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap) const
+    {
+        if (mode == Ripe::AES_GCM) {
+            // Header and segment number are authenticated with every segment
+            RipeByte additionalData[SIZE + 8];
+            std::copy(bytes, bytes + SIZE, additionalData);
+            writeBigEndian(additionalData + SIZE, segment, 8);
+            return encrypt ? context.encryptGCM(in, n, out, outCap, iv, additionalData, sizeof additionalData)
+                           : context.decryptGCM(in, n, out, outCap, iv, additionalData, sizeof additionalData);
+        }
+        return encrypt ? context.encrypt(in, n, out, outCap, iv) : context.decrypt(in, n, out, outCap, iv);
+    }
+
+    static const RipeByte CHUNKED_MAGIC[4];
+};
+
+const RipeByte ChunkedAESHeader::CHUNKED_MAGIC[4] = { 'R', 'I', 'P', 'C' };
+
+std::vector<Ripe::AESContext> createAESContexts(unsigned int count, const RipeByte* key, std::size_t keySize)
+{
+    std::vector<Ripe::AESContext> contexts;
+    contexts.reserve(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        contexts.emplace_back(key, keySize);
+    }
+    return contexts;
+}
+
+} // namespace
+
+std::string Ripe::encryptAESChunked(const std::string& data, const RipeByte* key, std::size_t keySize,
+                                    AESMode mode, unsigned int threads, std::size_t segmentSize)
+{
+    RIPE_STATS_SCOPE(STATS_AES_CHUNKED_ENCRYPT, data.size());
+    const ChunkedAESHeader header(mode, segmentSize, data.size());
+    const std::size_t count = header.segmentCount();
+    threads = std::min<std::size_t>(resolveThreadCount(threads), count);
+    std::vector<AESContext> contexts = createAESContexts(threads, key, keySize);
+
+    std::string result(static_cast<std::size_t>(header.totalSize()), '\0');
+    RipeByte* out = reinterpret_cast<RipeByte*>(&result[0]);
+    std::copy(header.bytes, header.bytes + ChunkedAESHeader::SIZE, out);
+    generateRandom(out + ChunkedAESHeader::SIZE, count * header.ivSize());
+
+    const RipeByte* in = reinterpret_cast<const RipeByte*>(data.data());
+    const std::size_t dataOffset = header.dataOffset();
+    const std::size_t fullCipherLength = header.cipherLength(segmentSize);
+    parallelFor(count, threads, [&](std::size_t segment, unsigned int worker) {
+        const std::size_t plainLength = header.plainLength(segment);
+        header.process(true, contexts[worker], segment, out + ChunkedAESHeader::SIZE + segment * header.ivSize(),
+                       in + segment * segmentSize, plainLength,
+                       out + dataOffset + segment * fullCipherLength, header.cipherLength(plainLength));
+    });
+    return result;
+}
+
+std::string Ripe::decryptAESChunked(const std::string& data, const RipeByte* key, std::size_t keySize, unsigned int threads)
+{
+    RIPE_STATS_SCOPE(STATS_AES_CHUNKED_DECRYPT, data.size());
+    const RipeByte* in = reinterpret_cast<const RipeByte*>(data.data());
+    const ChunkedAESHeader header = ChunkedAESHeader::read(in, data.size());
+    // Plain size is checked first so a forged header cannot overflow the expected size
+    if (header.plainSize > data.size() || header.totalSize() != data.size()) {
+        throw InvalidCiphertext("Chunked AES cipher is truncated or corrupted");
+    }
+    const std::size_t count = header.segmentCount();
+    threads = std::min<std::size_t>(resolveThreadCount(threads), count);
+    std::vector<AESContext> contexts = createAESContexts(threads, key, keySize);
+
+    std::string result(static_cast<std::size_t>(header.plainSize), '\0');
+    RipeByte* out = reinterpret_cast<RipeByte*>(&result[0]);
+    const std::size_t dataOffset = header.dataOffset();
+    const std::size_t fullCipherLength = header.cipherLength(header.maxPlainLength());
+    parallelFor(count, threads, [&](std::size_t segment, unsigned int worker) {
+        const std::size_t plainLength = header.plainLength(segment);
+        // CBC needs room for padding that is only removed during decryption
+        std::vector<RipeByte> buffer;
+        const std::size_t cipherLength = header.cipherLength(plainLength);
+        RipeByte* target = out + segment * header.segmentSize;
+        std::size_t outCap = plainLength;
+        if (header.mode == AES_CBC) {
+            buffer.resize(cipherLength);
+            target = buffer.data();
+            outCap = buffer.size();
+        }
+        std::size_t written = header.process(false, contexts[worker], segment, in + ChunkedAESHeader::SIZE + segment * header.ivSize(),
+                                             in + dataOffset + segment * fullCipherLength, cipherLength, target, outCap);
+        if (written != plainLength) {
+            throw InvalidCiphertext("Chunked AES cipher is corrupted");
+        }
+        if (header.mode == AES_CBC) {
+            std::copy(buffer.begin(), buffer.begin() + plainLength, out + segment * header.segmentSize);
+        }
+    });
+    return result;
+}
+
+namespace {
+
+std::ifstream openChunkedInput(const std::string& inputFile, std::uint64_t& size)
+{
+    std::ifstream in(inputFile.c_str(), std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error(
+                    std::string("Unable to open file for reading [" + inputFile + "] " + std::strerror(errno)).data()
+                    );
+    }
+    in.seekg(0, std::ios::end);
+    size = static_cast<std::uint64_t>(in.tellg());
+    in.seekg(0, std::ios::beg);
+    return in;
+}
+
+std::ofstream openChunkedOutput(const std::string& outputFile)
+{
+    std::ofstream out(outputFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error(
+                    std::string("Unable to open file for writing [" + outputFile + "] " + std::strerror(errno)).data()
+                    );
+    }
+    return out;
+}
+
+void readChunked(std::ifstream& in, RipeByte* buffer, std::size_t n)
+{
+    if (!in.read(reinterpret_cast<char*>(buffer), n)) {
+        throw std::runtime_error("Unable to read input file");
+    }
+}
+
+void writeChunked(std::ofstream& out, const RipeByte* buffer, std::size_t n)
+{
+    if (!out.write(reinterpret_cast<const char*>(buffer), n)) {
+        throw std::runtime_error("Unable to write output file");
+    }
+}
+
+} // namespace
+
+void Ripe::encryptAESFile(const std::string& inputFile, const std::string& outputFile, const RipeByte* key, std::size_t keySize,
+                          AESMode mode, unsigned int threads, std::size_t segmentSize)
+{
+    std::uint64_t plainSize = 0;
+    std::ifstream in = openChunkedInput(inputFile, plainSize);
+    const ChunkedAESHeader header(mode, segmentSize, plainSize);
+    const std::size_t count = header.segmentCount();
+    threads = std::min<std::size_t>(resolveThreadCount(threads), count);
+    std::vector<AESContext> contexts = createAESContexts(threads, key, keySize);
+
+    std::vector<RipeByte> ivs(count * header.ivSize());
+    generateRandom(ivs.data(), ivs.size());
+    std::ofstream out = openChunkedOutput(outputFile);
+    writeChunked(out, header.bytes, ChunkedAESHeader::SIZE);
+    writeChunked(out, ivs.data(), ivs.size());
+
+    // Keep every worker busy with two segments per window
+    const std::size_t window = std::min<std::size_t>(count, threads * 2);
+    const std::size_t plainStride = header.maxPlainLength();
+    const std::size_t fullCipherLength = header.cipherLength(plainStride);
+    std::vector<RipeByte> plain(std::max<std::size_t>(window * plainStride, 1));
+    std::vector<RipeByte> cipher(window * fullCipherLength);
+    for (std::size_t first = 0; first < count; first += window) {
+        const std::size_t segments = std::min(window, count - first);
+        std::size_t plainLength = 0;
+        std::size_t cipherLength = 0;
+        for (std::size_t i = 0; i < segments; ++i) {
+            plainLength += header.plainLength(first + i);
+            cipherLength += header.cipherLength(header.plainLength(first + i));
+        }
+        if (plainLength > 0) {
+            readChunked(in, plain.data(), plainLength);
+        }
+        parallelFor(segments, threads, [&](std::size_t i, unsigned int worker) {
+            const std::size_t segment = first + i;
+            const std::size_t segmentPlainLength = header.plainLength(segment);
+            header.process(true, contexts[worker], segment, ivs.data() + segment * header.ivSize(),
+                           plain.data() + i * plainStride, segmentPlainLength,
+                           cipher.data() + i * fullCipherLength, header.cipherLength(segmentPlainLength));
+        });
+        writeChunked(out, cipher.data(), cipherLength);
+    }
+}
+
+void Ripe::decryptAESFile(const std::string& inputFile, const std::string& outputFile, const RipeByte* key, std::size_t keySize,
+                          unsigned int threads)
+{
+    std::uint64_t fileSize = 0;
+    std::ifstream in = openChunkedInput(inputFile, fileSize);
+    RipeByte headerBytes[ChunkedAESHeader::SIZE];
+    if (fileSize < ChunkedAESHeader::SIZE) {
+        throw std::invalid_argument("Data is not chunked AES cipher");
+    }
+    readChunked(in, headerBytes, ChunkedAESHeader::SIZE);
+    const ChunkedAESHeader header = ChunkedAESHeader::read(headerBytes, ChunkedAESHeader::SIZE);
+    if (header.plainSize > fileSize || header.totalSize() != fileSize) {
+        throw InvalidCiphertext("Chunked AES cipher is truncated or corrupted");
+    }
+    const std::size_t count = header.segmentCount();
+    threads = std::min<std::size_t>(resolveThreadCount(threads), count);
+    std::vector<AESContext> contexts = createAESContexts(threads, key, keySize);
+
+    std::vector<RipeByte> ivs(count * header.ivSize());
+    readChunked(in, ivs.data(), ivs.size());
+    std::ofstream out = openChunkedOutput(outputFile);
+
+    const std::size_t window = std::min<std::size_t>(count, threads * 2);
+    const std::size_t fullCipherLength = header.cipherLength(header.maxPlainLength());
+    std::vector<RipeByte> cipher(window * fullCipherLength);
+    // CBC segments are decrypted with their padding so every segment gets full cipher length
+    std::vector<RipeByte> plain(window * fullCipherLength);
+    for (std::size_t first = 0; first < count; first += window) {
+        const std::size_t segments = std::min(window, count - first);
+        std::size_t cipherLength = 0;
+        for (std::size_t i = 0; i < segments; ++i) {
+            cipherLength += header.cipherLength(header.plainLength(first + i));
+        }
+        readChunked(in, cipher.data(), cipherLength);
+        parallelFor(segments, threads, [&](std::size_t i, unsigned int worker) {
+            const std::size_t segment = first + i;
+            const std::size_t segmentPlainLength = header.plainLength(segment);
+            const std::size_t written = header.process(false, contexts[worker], segment, ivs.data() + segment * header.ivSize(),
+                                                       cipher.data() + i * fullCipherLength, header.cipherLength(segmentPlainLength),
+                                                       plain.data() + i * fullCipherLength, fullCipherLength);
+            if (written != segmentPlainLength) {
+                throw InvalidCiphertext("Chunked AES cipher is corrupted");
+            }
+        });
+        for (std::size_t i = 0; i < segments; ++i) {
+            writeChunked(out, plain.data() + i * fullCipherLength, header.plainLength(first + i));
+        }
+    }
+}
+
+std::size_t Ripe::expectedAESChunkedLength(std::size_t plainDataSize, AESMode mode, std::size_t segmentSize)
+{
+    return static_cast<std::size_t>(ChunkedAESHeader(mode, segmentSize, plainDataSize).totalSize());
+}
+
+namespace {
+
+const RipeByte RSA_ENVELOPE_MAGIC[4] = { 'R', 'I', 'P', 'E' };
+const RipeByte RSA_ENVELOPE_VERSION = 1;
+const std::size_t RSA_ENVELOPE_KEY_SIZE = 32;
+
+} // namespace
+
+std::string Ripe::encryptRSAEnvelope(const std::string& data, const RSAPublicKeyHandle& publicKey)
+{
+    RIPE_STATS_SCOPE(STATS_RSA_ENVELOPE_ENCRYPT, data.size());
+    RSAES<PKCS1v15>::Encryptor encryptor(publicKey.m_impl->key);
+    const std::size_t encryptedKeySize = encryptor.CiphertextLength(RSA_ENVELOPE_KEY_SIZE);
+    if (encryptedKeySize == 0 || encryptedKeySize > 0xFFFF) {
+        throw std::invalid_argument("RSA key size can not be used for envelope");
+    }
+    SecByteBlock key(RSA_ENVELOPE_KEY_SIZE);
+    Ripe::generateRandom(key.data(), key.size());
+
+    std::string result(Ripe::expectedRSAEnvelopeLength(data.size(), publicKey.keySize()), '\0');
+    RipeByte* out = reinterpret_cast<RipeByte*>(&result[0]);
+    std::copy(RSA_ENVELOPE_MAGIC, RSA_ENVELOPE_MAGIC + 4, out);
+    out[4] = RSA_ENVELOPE_VERSION;
+    out[5] = 0;
+    writeBigEndian(out + 6, encryptedKeySize, 2);
+    LibraryRandomNumberGenerator rng;
+    encryptor.Encrypt(rng, key.data(), key.size(), out + RSA_ENVELOPE_HEADER_SIZE);
+
+    const std::size_t prefixSize = RSA_ENVELOPE_HEADER_SIZE + encryptedKeySize;
+    RipeByte* iv = out + prefixSize;
+    Ripe::generateRandom(iv, AES_GCM_IV_SIZE);
+    AESContext context(key.data(), key.size());
+    const std::size_t written = context.encryptGCM(reinterpret_cast<const RipeByte*>(data.data()), data.size(),
+                                                   iv + AES_GCM_IV_SIZE, result.size() - prefixSize - AES_GCM_IV_SIZE,
+                                                   iv, out, prefixSize);
+    result.resize(prefixSize + AES_GCM_IV_SIZE + written);
+    return result;
+}
+
+std::string Ripe::encryptRSAEnvelope(const std::string& data, const std::string& publicKeyPEM)
+{
+    return Ripe::encryptRSAEnvelope(data, RSAPublicKeyHandle(publicKeyPEM));
+}
+
+std::string Ripe::decryptRSAEnvelope(const std::string& data, RSADecryptor& decryptor)
+{
+    RIPE_STATS_SCOPE(STATS_RSA_ENVELOPE_DECRYPT, data.size());
+    const RipeByte* in = reinterpret_cast<const RipeByte*>(data.data());
+    if (data.size() < RSA_ENVELOPE_HEADER_SIZE || !std::equal(RSA_ENVELOPE_MAGIC, RSA_ENVELOPE_MAGIC + 4, in)) {
+        throw std::invalid_argument("Data is not RSA envelope");
+    }
+    if (in[4] != RSA_ENVELOPE_VERSION) {
+        throw std::invalid_argument("Unsupported RSA envelope version");
+    }
+    // Encrypted key is always one RSA block, anything else is rejected before it is decrypted
+    const RSAES<PKCS1v15>::Decryptor& rsa = decryptor.m_impl->decryptor;
+    const std::size_t encryptedKeySize = static_cast<std::size_t>(readBigEndian(in + 6, 2));
+    if (encryptedKeySize != rsa.FixedCiphertextLength()) {
+        throw InvalidCiphertext("RSA envelope key length does not match RSA key");
+    }
+    const std::size_t prefixSize = RSA_ENVELOPE_HEADER_SIZE + encryptedKeySize;
+    if (data.size() < prefixSize + AES_GCM_IV_SIZE + AES_GCM_TAG_SIZE) {
+        throw InvalidCiphertext("RSA envelope is truncated");
+    }
+    // AES key is only ever in secure block that is wiped when it is released
+    SecByteBlock key(rsa.FixedMaxPlaintextLength());
+    LibraryRandomNumberGenerator rng;
+    const DecodingResult decoded = rsa.Decrypt(rng, in + RSA_ENVELOPE_HEADER_SIZE, encryptedKeySize, key.BytePtr());
+    if (!decoded.isValidCoding || decoded.messageLength != RSA_ENVELOPE_KEY_SIZE) {
+        throw InvalidCiphertext("Invalid RSA envelope key");
+    }
+    AESContext context(key.BytePtr(), decoded.messageLength);
+
+    const RipeByte* iv = in + prefixSize;
+    std::string result(data.size() - prefixSize - AES_GCM_IV_SIZE - AES_GCM_TAG_SIZE, '\0');
+    const std::size_t written = context.decryptGCM(iv + AES_GCM_IV_SIZE, data.size() - prefixSize - AES_GCM_IV_SIZE,
+                                                   reinterpret_cast<RipeByte*>(&result[0]), result.size(),
+                                                   iv, in, prefixSize);
+    result.resize(written);
+    return result;
+}
+
+std::string Ripe::decryptRSAEnvelope(const std::string& data, const RSAPrivateKeyHandle& privateKey)
+{
+    RSADecryptor decryptor(privateKey);
+    return Ripe::decryptRSAEnvelope(data, decryptor);
+}
+
+std::string Ripe::decryptRSAEnvelope(const std::string& data, const std::string& privateKeyPEM, const std::string& secret)
+{
+    return Ripe::decryptRSAEnvelope(data, RSAPrivateKeyHandle(privateKeyPEM, secret));
+}
+
+std::string Ripe::encryptAES(const std::string& buffer, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv)
+{
+    return AESContext(key, keySize).encrypt(buffer, iv);
+}
+
+std::string Ripe::encryptAES(const std::string& data, const RipeByte* key, std::size_t keySize, const AESIV& iv)
+{
+    return AESContext(key, keySize).encrypt(data, iv);
+}
+
+std::size_t Ripe::encryptAES(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap,
+                             const RipeByte* key, std::size_t keySize, const RipeByte* iv)
+{
+    return AESContext(key, keySize).encrypt(in, n, out, outCap, iv);
+}
+
+std::string Ripe::encryptAES(std::string& data, const std::string& hexKey, const std::string& clientId, const std::string& outputFile, const std::string& ivec)
+{
+    std::stringstream ss;
+    if (!outputFile.empty()) {
+        AESIV iv;
+        if (ivec.empty()) {
+            generateRandom(iv.data(), iv.size());
+        } else if (!Ripe::parseIV(ivec, iv)) {
+            throw std::invalid_argument("Invalid IV");
+        }
+        std::string encrypted = AESContext(hexKey).encrypt(data, iv);
+
+        // Cipher is binary, written as a whole (it can contain NUL bytes)
+        std::ofstream out(outputFile.c_str(), std::ios::out | std::ios::binary);
+        if (!out.is_open()) {
+            throw std::runtime_error("Unable to open output file [" + outputFile + "]");
+        }
+        out.write(encrypted.data(), encrypted.size());
+        out.close();
+        ss << "IV: " << Ripe::ivToString(iv) << std::endl;
+    } else {
+        ss << Ripe::prepareData(data, hexKey, clientId.c_str(), ivec);
+    }
+    return ss.str();
+}
+
+std::string Ripe::decryptAES(const std::string& data, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv)
+{
+    return AESContext(key, keySize).decrypt(data, iv);
+}
+
+std::string Ripe::decryptAES(const std::string& data, const RipeByte* key, std::size_t keySize, const AESIV& iv)
+{
+    return AESContext(key, keySize).decrypt(data, iv);
+}
+
+std::size_t Ripe::decryptAES(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap,
+                             const RipeByte* key, std::size_t keySize, const RipeByte* iv)
+{
+    return AESContext(key, keySize).decrypt(in, n, out, outCap, iv);
+}
+
+std::string Ripe::decryptAES(std::string& data, const std::string& hexKey, std::string& ivec, bool isBase64, bool isHex)
+{
+    if (ivec.empty() && isBase64) {
+        // Extract IV from data
+        std::size_t pos = data.find_first_of(':');
+        if (pos == 32) {
+            ivec = data.substr(0, pos);
+            data.erase(0, pos + 1);
+            pos = data.find_first_of(':');
+            if (pos != std::string::npos) {
+                // We ignore clientId which is = data.substr(0, pos);
+                data.erase(0, pos + 1);
+            }
+        }
+    }
+    AESIV iv;
+    if (!Ripe::parseIV(ivec, iv)) {
+        throw std::invalid_argument("Invalid IV");
+    }
+
+    if (isBase64) {
+        data = Ripe::base64Decode(data);
+    }
+    if (isHex) {
+        data = Ripe::hexToString(data);
+    }
+    return AESContext(hexKey).decrypt(data, iv);
+}
+
+namespace {
+
+// zlib takes 32-bit sizes so larger buffers are passed in parts
+const std::size_t ZLIB_MAX_CHUNK = 1U << 30;
+
+std::runtime_error zlibError(const char* operation, int ret, const z_stream& zs)
+{
+    std::ostringstream oss;
+    oss << "Exception during zlib " << operation << ": (" << ret << ") " << (zs.msg != NULL ? zs.msg : "no msg");
+    return std::runtime_error(oss.str());
+}
+
+// Makes room for at least minimum more bytes after length. Output written since start at least doubles
+// every time so appends stay amortized without over-allocating when output already has other data
+void growZlibOutput(std::string& output, std::size_t start, std::size_t length, std::size_t minimum)
+{
+    if (output.size() - length < minimum) {
+        output.resize(length + std::max(minimum, length - start));
+    }
+}
+
+} // namespace
+
+struct Ripe::ZlibCompressor::Impl
+{
+    z_stream zs;
+
+    explicit Impl(const ZlibOptions& options)
+    {
+        memset(&zs, 0, sizeof(zs));
+        const int ret = deflateInit2(&zs, options.level, Z_DEFLATED, options.windowBits, options.memLevel, options.strategy);
+        if (ret == Z_STREAM_ERROR) {
+            throw std::invalid_argument("Invalid zlib options");
+        }
+        if (ret != Z_OK) {
+            throw std::runtime_error("Unable to initialize zlib deflate");
+        }
+    }
+
+    ~Impl()
+    {
+        deflateEnd(&zs);
+    }
+
+    // Deflates until all input is consumed (and stream is ended for Z_FINISH)
+    void run(const RipeByte* in, std::size_t n, int flush, std::string& output, std::size_t expectedSize)
+    {
+        const std::size_t start = output.size();
+        std::size_t length = start;
+        growZlibOutput(output, start, length, expectedSize);
+        do {
+            const std::size_t chunk = std::min(n, ZLIB_MAX_CHUNK);
+            const int chunkFlush = chunk == n ? flush : Z_NO_FLUSH;
+            zs.next_in = const_cast<Bytef*>(in);
+            zs.avail_in = static_cast<uInt>(chunk);
+            int ret;
+            do {
+                growZlibOutput(output, start, length, 64);
+                const std::size_t available = std::min(output.size() - length, ZLIB_MAX_CHUNK);
+                zs.next_out = reinterpret_cast<Bytef*>(&output[length]);
+                zs.avail_out = static_cast<uInt>(available);
+                ret = deflate(&zs, chunkFlush);
+                if (ret == Z_STREAM_ERROR) {
+                    throw zlibError("compression", ret, zs);
+                }
+                length += available - zs.avail_out;
+            } while (chunkFlush == Z_FINISH ? ret != Z_STREAM_END : zs.avail_out == 0);
+            in += chunk;
+            n -= chunk;
+        } while (n > 0);
+        output.resize(length);
+    }
+};
+
+Ripe::ZlibCompressor::ZlibCompressor(const ZlibOptions& options) :
+    m_impl(new Impl(options))
+{
+}
+
+Ripe::ZlibCompressor::ZlibCompressor(ZlibCompressor&&) = default;
+
+Ripe::ZlibCompressor& Ripe::ZlibCompressor::operator=(ZlibCompressor&&) = default;
+
+Ripe::ZlibCompressor::~ZlibCompressor()
+{
+}
+
+std::string Ripe::ZlibCompressor::compress(const std::string& data)
+{
+    std::string output;
+    compress(reinterpret_cast<const RipeByte*>(data.data()), data.size(), output);
+    return output;
+}
+
+std::size_t Ripe::ZlibCompressor::compress(const RipeByte* in, std::size_t n, std::string& output)
+{
+    const std::size_t start = output.size();
+    // With room for deflateBound bytes whole message is compressed in one deflate call
+    m_impl->run(in, n, Z_FINISH, output, bound(n));
+    deflateReset(&m_impl->zs);
+    return output.size() - start;
+}
+
+void Ripe::ZlibCompressor::update(const RipeByte* in, std::size_t n, std::string& output)
+{
+    m_impl->run(in, n, Z_NO_FLUSH, output, 64);
+}
+
+void Ripe::ZlibCompressor::final(std::string& output)
+{
+    m_impl->run(nullptr, 0, Z_FINISH, output, 64);
+    deflateReset(&m_impl->zs);
+}
+
+void Ripe::ZlibCompressor::reset()
+{
+    deflateReset(&m_impl->zs);
+}
+
+std::size_t Ripe::ZlibCompressor::bound(std::size_t n) const
+{
+    if (n > ZLIB_MAX_CHUNK) {
+        // deflateBound takes 32-bit length, stored blocks add 5 bytes per 16 KB at most
+        return n + (n >> 12) + (n >> 14) + 64;
+    }
+    return deflateBound(&m_impl->zs, static_cast<uLong>(n));
+}
+
+struct Ripe::ZlibDecompressor::Impl
+{
+    z_stream zs;
+
+    explicit Impl(const ZlibOptions& options)
+    {
+        memset(&zs, 0, sizeof(zs));
+        const int ret = inflateInit2(&zs, options.windowBits);
+        if (ret == Z_STREAM_ERROR) {
+            throw std::invalid_argument("Invalid zlib options");
+        }
+        if (ret != Z_OK) {
+            throw std::runtime_error("Unable to initialize zlib inflate");
+        }
+    }
+
+    ~Impl()
+    {
+        inflateEnd(&zs);
+    }
+};
+
+Ripe::ZlibDecompressor::ZlibDecompressor(const ZlibOptions& options) :
+    m_impl(new Impl(options))
+{
+}
+
+Ripe::ZlibDecompressor::ZlibDecompressor(ZlibDecompressor&&) = default;
+
+Ripe::ZlibDecompressor& Ripe::ZlibDecompressor::operator=(ZlibDecompressor&&) = default;
+
+Ripe::ZlibDecompressor::~ZlibDecompressor()
+{
+}
+
+std::string Ripe::ZlibDecompressor::decompress(const std::string& data)
+{
+    std::string output;
+    if (!update(reinterpret_cast<const RipeByte*>(data.data()), data.size(), output)) {
+        reset();
+        throw zlibError("decompression", Z_BUF_ERROR, m_impl->zs);
+    }
+    return output;
+}
+
+bool Ripe::ZlibDecompressor::update(const RipeByte* in, std::size_t n, std::string& output)
+{
+    z_stream& zs = m_impl->zs;
+    const std::size_t start = output.size();
+    std::size_t length = start;
+    // Most data compresses at least 2:1, output grows if that is not enough
+    growZlibOutput(output, start, length, std::max<std::size_t>(std::min(n, ZLIB_MAX_CHUNK) * 2, 1024));
+    do {
+        const std::size_t chunk = std::min(n, ZLIB_MAX_CHUNK);
+        zs.next_in = const_cast<Bytef*>(in);
+        zs.avail_in = static_cast<uInt>(chunk);
+        int ret;
+        do {
+            growZlibOutput(output, start, length, 1024);
+            const std::size_t available = std::min(output.size() - length, ZLIB_MAX_CHUNK);
+            zs.next_out = reinterpret_cast<Bytef*>(&output[length]);
+            zs.avail_out = static_cast<uInt>(available);
+            ret = inflate(&zs, Z_NO_FLUSH);
+            length += available - zs.avail_out;
+            if (ret == Z_STREAM_END) {
+                output.resize(length);
+                inflateReset(&zs);
+                return true;
+            }
+            if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                output.resize(length);
+                const std::runtime_error error = zlibError("decompression", ret, zs);
+                inflateReset(&zs);
+                throw error;
+            }
+        } while (zs.avail_out == 0);
+        in += chunk;
+        n -= chunk;
+    } while (n > 0);
+    output.resize(length);
+    return false;
+}
+
+void Ripe::ZlibDecompressor::reset()
+{
+    inflateReset(&m_impl->zs);
+}
+
+std::string Ripe::compressString(const std::string& str)
+{
+    return Ripe::compressString(str, ZlibOptions());
+}
+
+std::string Ripe::compressString(const std::string& str, const ZlibOptions& options)
+{
+    RIPE_STATS_SCOPE(STATS_ZLIB_COMPRESS, str.size());
+    return ZlibCompressor(options).compress(str);
+}
+
+std::string Ripe::decompressString(const std::string& str)
+{
+    return Ripe::decompressString(str, ZlibOptions());
+}
+
+std::string Ripe::decompressString(const std::string& str, const ZlibOptions& options)
+{
+    RIPE_STATS_SCOPE(STATS_ZLIB_DECOMPRESS, str.size());
+    return ZlibDecompressor(options).decompress(str);
+}
+
+namespace {
+
+const std::size_t GZIP_BLOCK_SIZE = 131072;
+const std::size_t GZIP_DICTIONARY_SIZE = 32768;
+
+// Raw deflate of one block of parallel gzip. Every block except last ends with sync flush so it is byte aligned
+// and not final, that way blocks can be joined in to single gzip member
+struct GzipBlockDeflater
+{
+    z_stream zs;
+
+    explicit GzipBlockDeflater(int level)
+    {
+        memset(&zs, 0, sizeof(zs));
+        const int ret = deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        if (ret == Z_STREAM_ERROR) {
+            throw std::invalid_argument("Invalid zlib compression level");
+        }
+        if (ret != Z_OK) {
+            throw std::runtime_error("Unable to initialize zlib deflate");
+        }
+    }
+
+    ~GzipBlockDeflater()
+    {
+        deflateEnd(&zs);
+    }
+
+    GzipBlockDeflater(const GzipBlockDeflater&) = delete;
+    GzipBlockDeflater& operator=(const GzipBlockDeflater&) = delete;
+
+    void compress(const RipeByte* in, std::size_t n, const RipeByte* dictionary, std::size_t dictionarySize, bool last,
+                  std::string& output)
+    {
+        deflateReset(&zs);
+        if (dictionarySize > 0) {
+            // Previous 32 KB lets matches cross block boundary, so ratio is close to single stream
+            deflateSetDictionary(&zs, dictionary, static_cast<uInt>(dictionarySize));
+        }
+        const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+        output.resize(deflateBound(&zs, static_cast<uLong>(n)) + 16);
+        zs.next_in = const_cast<Bytef*>(in);
+        zs.avail_in = static_cast<uInt>(n);
+        std::size_t length = 0;
+        for (;;) {
+            zs.next_out = reinterpret_cast<Bytef*>(&output[length]);
+            zs.avail_out = static_cast<uInt>(output.size() - length);
+            const int ret = deflate(&zs, flush);
+            if (ret == Z_STREAM_ERROR) {
+                throw zlibError("compression", ret, zs);
+            }
+            length = output.size() - zs.avail_out;
+            if (last ? ret == Z_STREAM_END : zs.avail_out != 0) {
+                break;
+            }
+            output.resize(output.size() * 2);
+        }
+        output.resize(length);
+    }
+};
+
+void writeLittleEndian32(std::ofstream& out, std::uint32_t value)
+{
+    const RipeByte bytes[4] = {
+        static_cast<RipeByte>(value), static_cast<RipeByte>(value >> 8),
+        static_cast<RipeByte>(value >> 16), static_cast<RipeByte>(value >> 24)
+    };
+    writeChunked(out, bytes, sizeof bytes);
+}
+
+} // namespace
+
+bool Ripe::compressFile(const std::string& gzFilename, const std::string& inputFile, unsigned int threads, int level)
+{
+    std::uint64_t size = 0;
+    std::ifstream in = openChunkedInput(inputFile, size);
+    std::ofstream out = openChunkedOutput(gzFilename);
+
+    threads = resolveThreadCount(threads);
+    std::vector<std::unique_ptr<GzipBlockDeflater> > deflaters;
+    for (unsigned int i = 0; i < threads; ++i) {
+        deflaters.emplace_back(new GzipBlockDeflater(level));
+    }
+
+    // Header without name or time, extra flags tell whether best (2) or fastest (4) level was used
+    const RipeByte header[10] = { 0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0,
+                                  static_cast<RipeByte>(level == Z_BEST_COMPRESSION ? 2 : level == Z_BEST_SPEED ? 4 : 0), 3 };
+    writeChunked(out, header, sizeof header);
+
+    // Few blocks per thread are read at a time, buffer starts with dictionary for first block of window
+    const std::size_t windowBlocks = threads * 4;
+    const std::size_t windowSize = GZIP_BLOCK_SIZE * windowBlocks;
+    std::vector<RipeByte> buffer(GZIP_DICTIONARY_SIZE + static_cast<std::size_t>(std::min<std::uint64_t>(windowSize, size)));
+    RipeByte* data = buffer.data() + GZIP_DICTIONARY_SIZE;
+    std::vector<std::string> blocks(windowBlocks);
+    std::vector<uLong> checksums(windowBlocks);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    std::size_t dictionarySize = 0;
+    std::uint64_t remaining = size;
+    do {
+        const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(windowSize, remaining));
+        readChunked(in, data, n);
+        remaining -= n;
+        // Empty file still needs one (empty) final block
+        const std::size_t count = std::max<std::size_t>((n + GZIP_BLOCK_SIZE - 1) / GZIP_BLOCK_SIZE, 1);
+        parallelFor(count, threads, [&](std::size_t i, unsigned int worker) {
+            const std::size_t offset = i * GZIP_BLOCK_SIZE;
+            const std::size_t length = std::min(GZIP_BLOCK_SIZE, n - offset);
+            const std::size_t blockDictionarySize = i == 0 ? dictionarySize : GZIP_DICTIONARY_SIZE;
+            deflaters[worker]->compress(data + offset, length, data + offset - blockDictionarySize, blockDictionarySize,
+                                        remaining == 0 && i == count - 1, blocks[i]);
+            checksums[i] = crc32(0L, data + offset, static_cast<uInt>(length));
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            writeChunked(out, reinterpret_cast<const RipeByte*>(blocks[i].data()), blocks[i].size());
+            crc = crc32_combine(crc, checksums[i], static_cast<z_off_t>(std::min(GZIP_BLOCK_SIZE, n - i * GZIP_BLOCK_SIZE)));
+        }
+        if (remaining > 0) {
+            // Window is always larger than dictionary
+            std::copy(data + n - GZIP_DICTIONARY_SIZE, data + n, buffer.data());
+            dictionarySize = GZIP_DICTIONARY_SIZE;
+        }
+    } while (remaining > 0);
+
+    writeLittleEndian32(out, static_cast<std::uint32_t>(crc));
+    writeLittleEndian32(out, static_cast<std::uint32_t>(size));
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Unable to write output file");
+    }
+    return true;
+}
+
+bool Ripe::decompressFile(const std::string& gzFilename, const std::string& outputFile)
+{
+    gzFile in = gzopen(gzFilename.c_str(), "rb");
+    if (!in) {
+        throw std::runtime_error(
+                    std::string("Unable to open file for reading [" + gzFilename + "] " + std::strerror(errno)).data()
+                    );
+    }
+    gzbuffer(in, static_cast<unsigned int>(STREAM_CHUNK_SIZE));
+    std::ofstream out;
+    try {
+        out = openChunkedOutput(outputFile);
+        std::vector<char> buffer(STREAM_CHUNK_SIZE);
+        bool first = true;
+        for (;;) {
+            const int n = gzread(in, buffer.data(), static_cast<unsigned int>(buffer.size()));
+            if (n < 0) {
+                int errorNumber = 0;
+                throw std::runtime_error("Error during decompression " + std::string(gzerror(in, &errorNumber)));
+            }
+            if (first && gzdirect(in)) {
+                // zlib copies data that is not gzip as-is
+                throw std::invalid_argument("File is not gzip [" + gzFilename + "]");
+            }
+            first = false;
+            if (n == 0) {
+                break;
+            }
+            writeChunked(out, reinterpret_cast<const RipeByte*>(buffer.data()), static_cast<std::size_t>(n));
+        }
+    } catch (...) {
+        gzclose(in);
+        throw;
+    }
+    // Truncated file is only reported when closing
+    if (gzclose(in) != Z_OK) {
+        throw std::runtime_error("Error during decompression, file is truncated or corrupt [" + gzFilename + "]");
+    }
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Unable to write output file");
+    }
+    return true;
+}
+
+std::string Ripe::sha256Hash(const std::string& data)
+{
+    Hasher hasher(HASH_SHA256);
+    hasher.update(data);
+    return hasher.final();
+}
+
+std::string Ripe::sha512Hash(const std::string& data)
+{
+    Hasher hasher(HASH_SHA512);
+    hasher.update(data);
+    return hasher.final();
+}
+
+struct Ripe::Hasher::Impl
+{
+    std::unique_ptr<HashTransformation> hash;
+
+    explicit Impl(HashAlgorithm algorithm)
+    {
+        switch (algorithm) {
+        case HASH_SHA256:
+            hash.reset(new SHA256);
+            break;
+        case HASH_SHA512:
+            hash.reset(new CryptoPP::SHA512);
+            break;
+        case HASH_BLAKE2B:
+#ifdef RIPE_HAS_BLAKE2
+            hash.reset(new BLAKE2b);
+            break;
+#else
+            throw std::invalid_argument("BLAKE2b requires Crypto++ 5.6.4 or newer");
+#endif
+        default:
+            throw std::invalid_argument("Invalid hash algorithm");
+        }
+    }
+};
+
+Ripe::Hasher::Hasher(HashAlgorithm algorithm) :
+    m_impl(new Impl(algorithm))
+{
+}
+
+Ripe::Hasher::Hasher(Hasher&&) = default;
+
+Ripe::Hasher& Ripe::Hasher::operator=(Hasher&&) = default;
+
+Ripe::Hasher::~Hasher()
+{
+}
+
+void Ripe::Hasher::update(const RipeByte* in, std::size_t n)
+{
+    RIPE_STATS_SCOPE(STATS_HASH_UPDATE, n);
+    m_impl->hash->Update(in, n);
+}
+
+void Ripe::Hasher::update(const std::string& data)
+{
+    update(reinterpret_cast<const RipeByte*>(data.data()), data.size());
+}
+
+std::size_t Ripe::Hasher::final(RipeByte* out, std::size_t outCap)
+{
+    const std::size_t size = digestSize();
+    if (outCap < size) {
+        throw std::invalid_argument("Output buffer too small for digest");
+    }
+    // Final also restarts the hash for next message
+    m_impl->hash->Final(out);
+    return size;
+}
+
+std::string Ripe::Hasher::final()
+{
+    RipeByte digest[CryptoPP::SHA512::DIGESTSIZE];
+    const std::size_t size = final(digest, sizeof digest);
+    std::string result(size * 2, '\0');
+    RipeCodec::hexEncode(digest, size, reinterpret_cast<RipeByte*>(&result[0]));
+    return result;
+}
+
+void Ripe::Hasher::reset()
+{
+    m_impl->hash->Restart();
+}
+
+std::size_t Ripe::Hasher::digestSize() const
+{
+    return m_impl->hash->DigestSize();
+}
+
+std::vector<RipeByte> Ripe::hashBatch(const std::vector<std::string>& data, HashAlgorithm algorithm, unsigned int threads)
+{
+    const std::size_t size = hashDigestSize(algorithm);
+    std::vector<RipeByte> digests(data.size() * size);
+    // Records are usually small so they are handed out to workers in blocks
+    const std::size_t blockSize = 256;
+    const std::size_t blocks = (data.size() + blockSize - 1) / blockSize;
+    threads = std::min<std::size_t>(resolveThreadCount(threads), std::max<std::size_t>(blocks, 1));
+    std::vector<Hasher> hashers;
+    for (unsigned int i = 0; i < threads; ++i) {
+        hashers.emplace_back(algorithm);
+    }
+    parallelFor(blocks, threads, [&](std::size_t block, unsigned int worker) {
+        Hasher& hasher = hashers[worker];
+        const std::size_t end = std::min(data.size(), (block + 1) * blockSize);
+        for (std::size_t i = block * blockSize; i < end; ++i) {
+            hasher.update(data[i]);
+            hasher.final(&digests[i * size], size);
+        }
+    });
+    return digests;
+}
+
+std::size_t Ripe::hashDigestSize(HashAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case HASH_SHA256:
+        return SHA256::DIGESTSIZE;
+    case HASH_SHA512:
+    case HASH_BLAKE2B:
+        return CryptoPP::SHA512::DIGESTSIZE;
+    }
+    throw std::invalid_argument("Invalid hash algorithm");
+}
+
+bool Ripe::isHashAlgorithmSupported(HashAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case HASH_SHA256:
+    case HASH_SHA512:
+        return true;
+    case HASH_BLAKE2B:
+#ifdef RIPE_HAS_BLAKE2
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+#ifndef _WIN32
+namespace {
+
+// Hashes regular file through read-only mapping. Returns false (without updating hasher) if file
+// cannot be mapped, e.g, it is a pipe or empty, so that caller can read it instead
+bool hashMappedFile(const std::string& filename, Ripe::Hasher& hasher)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0
+            || static_cast<std::uint64_t>(st.st_size) > std::numeric_limits<std::size_t>::max()) {
+        close(fd);
+        return false;
+    }
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    // Pages that are already hashed are released every window so resident memory stays
+    // constant instead of growing to size of file
+    const std::size_t window = Ripe::STREAM_CHUNK_SIZE * 64;
+    RipeByte* data = static_cast<RipeByte*>(mapped);
+    for (std::size_t offset = 0; offset < size; offset += window) {
+        const std::size_t n = std::min(window, size - offset);
+        hasher.update(data + offset, n);
+        madvise(data + offset, n, MADV_DONTNEED);
+    }
+    munmap(mapped, size);
+    return true;
+}
+
+} // namespace
+#endif
+
+std::string Ripe::hashFile(const std::string& filename, HashAlgorithm algorithm)
+{
+    RIPE_STATS_SCOPE(STATS_HASH_FILE, 0);
+    Hasher hasher(algorithm);
+#ifndef _WIN32
+    if (hashMappedFile(filename, hasher)) {
+        return hasher.final();
+    }
+#endif
+    std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Unable to open input file [" + filename + "]");
+    }
+    std::vector<RipeByte> buffer(Ripe::STREAM_CHUNK_SIZE);
+    while (in) {
+        in.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        hasher.update(buffer.data(), static_cast<std::size_t>(in.gcount()));
+    }
+    if (in.bad()) {
+        throw std::runtime_error("Unable to read input file [" + filename + "]");
+    }
+    return hasher.final();
+}
+
+std::string Ripe::prepareData(const std::string& data, const std::string& hexKey, const char* clientId, const std::string& ivec)
+{
+    // Random IV is used if none is provided
+    AESIV iv;
+    const bool hasIV = !ivec.empty();
+    if (hasIV && !Ripe::parseIV(ivec, iv)) {
+        throw std::invalid_argument("Invalid IV");
+    }
+    AESContext context(hexKey);
+    std::string result;
+    Ripe::prepareData(data, context, result, clientId, hasIV ? iv.data() : nullptr);
+    return result;
+}
+
+namespace {
+
+// Writes [IV]:[[Client_ID]:] at out and returns end of header
+char* writePacketHeader(char* out, const RipeByte* iv, std::size_t ivSize, const std::string& clientId)
+{
+    static const char* HEX_LOWER = "0123456789abcdef";
+
+    // IV Hex
+    for (std::size_t i = 0; i < ivSize; ++i) {
+        *out++ = HEX_LOWER[iv[i] >> 4];
+        *out++ = HEX_LOWER[iv[i] & 0x0F];
+    }
+    *out++ = Ripe::DATA_DELIMITER;
+    if (!clientId.empty()) {
+        out = std::copy(clientId.begin(), clientId.end(), out);
+        *out++ = Ripe::DATA_DELIMITER;
+    }
+    return out;
+}
+
+// Writes [IV]:[[Client_ID]:]:[Base64 Cipher][PACKET_DELIMITER] at out and returns end of packet
+char* writePacket(char* out, const RipeByte* iv, std::size_t ivSize, const std::string& clientId,
+                  const RipeByte* cipher, std::size_t cipherSize)
+{
+    out = writePacketHeader(out, iv, ivSize, clientId);
+    out += Ripe::base64Encode(cipher, cipherSize, reinterpret_cast<RipeByte*>(out), Ripe::expectedBase64Length(cipherSize));
+    return std::copy(Ripe::PACKET_DELIMITER.begin(), Ripe::PACKET_DELIMITER.end(), out);
+}
+
+} // namespace
+
+std::size_t Ripe::prepareData(const std::string& data, AESContext& context, std::string& output,
+                              const std::string& clientId, const RipeByte* iv)
+{
+    RIPE_STATS_SCOPE(STATS_PACKET_PREPARE, data.size());
+    RipeByte ivArr[Ripe::AES_BLOCK_SIZE];
+    if (iv == nullptr) {
+        generateRandom(ivArr, sizeof ivArr);
+    } else {
+        std::copy(iv, iv + Ripe::AES_BLOCK_SIZE, ivArr);
+    }
+
+    // Cipher is needed before base64 encoding it in to output, scratch buffer
+    // comes from thread's pool so it is not reallocated for every packet
+    ScratchBuffer cipher(Ripe::expectedAESCipherLength(data.size()));
+    context.encrypt(reinterpret_cast<const RipeByte*>(data.data()), data.size(), cipher.data(), cipher.size(), ivArr);
+
+    const std::size_t start = output.size();
+    output.resize(start + Ripe::expectedDataSize(data.size(), clientId.size()));
+    char* end = writePacket(&output[start], ivArr, sizeof ivArr, clientId, cipher.data(), cipher.size());
+    output.resize(static_cast<std::size_t>(end - output.data()));
+    return output.size() - start;
+}
+
+namespace {
+
+// Compressed data is processed in chunks of multiple of 48 bytes (AES block and base64 group)
+// so every chunk can be encrypted and encoded on its own and still form one continuous packet
+const std::size_t PIPELINE_CHUNK_SIZE = 48 * 1024;
+
+// Encrypts n bytes of buffer in place (continuing CBC chain) and appends its base64 to output
+void encryptAndEncode(CBC_Mode<AES>::Encryption& encryption, RipeByte* buffer, std::size_t n, std::string& output)
+{
+    encryption.ProcessData(buffer, buffer, n);
+    const std::size_t length = output.size();
+    output.resize(length + Ripe::expectedBase64Length(n));
+    output.resize(length + Ripe::base64Encode(buffer, n, reinterpret_cast<RipeByte*>(&output[length]), output.size() - length));
+}
+
+} // namespace
+
+std::size_t Ripe::prepareCompressedData(const std::string& data, AESContext& context, ZlibCompressor& compressor,
+                                        std::string& output, const std::string& clientId, const RipeByte* iv)
+{
+    RIPE_STATS_SCOPE(STATS_PACKET_PREPARE_COMPRESSED, data.size());
+    RipeByte ivArr[Ripe::AES_BLOCK_SIZE];
+    if (iv == nullptr) {
+        generateRandom(ivArr, sizeof ivArr);
+    } else {
+        std::copy(iv, iv + Ripe::AES_BLOCK_SIZE, ivArr);
+    }
+
+    const std::size_t start = output.size();
+    output.resize(start + sizeof ivArr * 2 + 1 + (clientId.empty() ? 0 : clientId.size() + 1));
+    writePacketHeader(&output[start], ivArr, sizeof ivArr, clientId);
+
+    CBC_Mode<AES>::Encryption& encryption = context.m_impl->encryption();
+    encryption.Resynchronize(ivArr, Ripe::AES_BLOCK_SIZE);
+
+    // Room for padding block after last chunk, compressed plain data is wiped on release
+    ScratchBuffer buffer(PIPELINE_CHUNK_SIZE + Ripe::AES_BLOCK_SIZE, true);
+
+    z_stream& zs = compressor.m_impl->zs;
+    const RipeByte* in = reinterpret_cast<const RipeByte*>(data.data());
+    std::size_t remaining = data.size();
+    std::size_t pending = 0;
+    int ret;
+    do {
+        if (zs.avail_in == 0 && remaining > 0) {
+            const std::size_t chunk = std::min(remaining, ZLIB_MAX_CHUNK);
+            zs.next_in = const_cast<Bytef*>(in);
+            zs.avail_in = static_cast<uInt>(chunk);
+            in += chunk;
+            remaining -= chunk;
+        }
+        zs.next_out = buffer.data() + pending;
+        zs.avail_out = static_cast<uInt>(PIPELINE_CHUNK_SIZE - pending);
+        ret = deflate(&zs, remaining == 0 ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR) {
+            deflateReset(&zs);
+            throw zlibError("compression", ret, zs);
+        }
+        pending = PIPELINE_CHUNK_SIZE - zs.avail_out;
+        if (pending == PIPELINE_CHUNK_SIZE) {
+            encryptAndEncode(encryption, buffer.data(), pending, output);
+            pending = 0;
+        }
+    } while (ret != Z_STREAM_END);
+    deflateReset(&zs);
+
+    // PKCS #7 padding for last block
+    const std::size_t padding = Ripe::AES_BLOCK_SIZE - pending % Ripe::AES_BLOCK_SIZE;
+    std::fill(buffer.data() + pending, buffer.data() + pending + padding, static_cast<RipeByte>(padding));
+    encryptAndEncode(encryption, buffer.data(), pending + padding, output);
+
+    output.append(Ripe::PACKET_DELIMITER);
+    return output.size() - start;
+}
+
+std::string Ripe::prepareCompressedData(const std::string& data, const std::string& hexKey, const std::string& clientId, const std::string& ivec)
+{
+    // Random IV is used if none is provided
+    AESIV iv;
+    const bool hasIV = !ivec.empty();
+    if (hasIV && !Ripe::parseIV(ivec, iv)) {
+        throw std::invalid_argument("Invalid IV");
+    }
+    AESContext context(hexKey);
+    ZlibCompressor compressor;
+    std::string result;
+    Ripe::prepareCompressedData(data, context, compressor, result, clientId, hasIV ? iv.data() : nullptr);
+    return result;
+}
+
+std::string Ripe::decryptCompressedData(const std::string& data, AESContext& context, ZlibDecompressor& decompressor,
+                                        std::string& clientId)
+{
+    RIPE_STATS_SCOPE(STATS_PACKET_DECRYPT_COMPRESSED, data.size());
+    std::size_t end = data.size();
+    if (end >= PACKET_DELIMITER_SIZE && data.compare(end - PACKET_DELIMITER_SIZE, PACKET_DELIMITER_SIZE, PACKET_DELIMITER) == 0) {
+        end -= PACKET_DELIMITER_SIZE;
+    }
+    const std::size_t ivHexSize = Ripe::AES_BLOCK_SIZE * 2;
+    std::size_t pos = data.find(Ripe::DATA_DELIMITER);
+    RipeByte iv[Ripe::AES_BLOCK_SIZE];
+    if (pos != ivHexSize || pos > end
+            || Ripe::hexToString(reinterpret_cast<const RipeByte*>(data.data()), ivHexSize, iv, sizeof iv) != sizeof iv) {
+        throw std::invalid_argument("Invalid data, expected [IV]:[[Client_ID]:]:[Base64 Data]");
+    }
+    std::size_t payloadStart = pos + 1;
+    pos = data.find(Ripe::DATA_DELIMITER, payloadStart);
+    if (pos != std::string::npos && pos < end) {
+        clientId.assign(data, payloadStart, pos - payloadStart);
+        payloadStart = pos + 1;
+    } else {
+        clientId.clear();
+    }
+
+    CBC_Mode<AES>::Decryption& decryption = context.m_impl->decryption();
+    decryption.Resynchronize(iv, Ripe::AES_BLOCK_SIZE);
+
+    // Base64 of one full chunk
+    const std::size_t encodedChunkSize = PIPELINE_CHUNK_SIZE / 3 * 4;
+    // Last block of every chunk is held back in front of the next one so that
+    // padding is only ever checked on the very last block
+    ScratchBuffer buffer(Ripe::AES_BLOCK_SIZE + PIPELINE_CHUNK_SIZE, true);
+    std::size_t held = 0;
+
+    decompressor.reset();
+    std::string result;
+    bool finished = false;
+    const RipeByte* in = reinterpret_cast<const RipeByte*>(data.data()) + payloadStart;
+    std::size_t remaining = end - payloadStart;
+    if (remaining == 0) {
+        throw InvalidCiphertext("StreamTransformationFilter: ciphertext length is not a multiple of block size");
+    }
+    while (remaining > 0) {
+        std::size_t encoded = std::min(remaining, encodedChunkSize);
+        std::size_t decoded = Ripe::base64Decode(in, encoded, buffer.data() + held, buffer.size() - held);
+        if (encoded < remaining && decoded != PIPELINE_CHUNK_SIZE) {
+            // Characters were skipped (e.g, line breaks) so chunk is not aligned
+            // to base64 groups, rest of the payload is decoded at once
+            encoded = remaining;
+            buffer.resize(held + Ripe::maxBase64DecodedLength(encoded));
+            decoded = Ripe::base64Decode(in, encoded, buffer.data() + held, buffer.size() - held);
+        }
+        in += encoded;
+        remaining -= encoded;
+        decoded += held;
+        if (decoded == 0 || decoded % Ripe::AES_BLOCK_SIZE != 0) {
+            decompressor.reset();
+            throw InvalidCiphertext("StreamTransformationFilter: ciphertext length is not a multiple of block size");
+        }
+        held = remaining == 0 ? 0 : Ripe::AES_BLOCK_SIZE;
+        const std::size_t ready = decoded - held;
+        decryption.ProcessData(buffer.data(), buffer.data(), ready);
+
+        std::size_t plainSize = ready;
+        if (remaining == 0) {
+            const std::size_t padding = buffer.data()[ready - 1];
+            bool validPadding = padding > 0 && padding <= static_cast<std::size_t>(Ripe::AES_BLOCK_SIZE);
+            for (std::size_t i = 1; validPadding && i <= padding; ++i) {
+                validPadding = buffer.data()[ready - i] == padding;
+            }
+            if (!validPadding) {
+                decompressor.reset();
+                throw InvalidCiphertext("StreamTransformationFilter: invalid PKCS #7 block padding found");
+            }
+            plainSize -= padding;
+        }
+        if (!finished) {
+            // Anything after end of compressed message is ignored, same as decompressString
+            finished = decompressor.update(buffer.data(), plainSize, result);
+        }
+        std::copy(buffer.data() + ready, buffer.data() + decoded, buffer.data());
+    }
+    if (!finished) {
+        decompressor.reset();
+        throw zlibError("decompression", Z_BUF_ERROR, decompressor.m_impl->zs);
+    }
+    return result;
+}
+
+std::string Ripe::decryptCompressedData(const std::string& data, const std::string& hexKey)
+{
+    AESContext context(hexKey);
+    ZlibDecompressor decompressor;
+    std::string clientId;
+    return Ripe::decryptCompressedData(data, context, decompressor, clientId);
+}
+
+std::string Ripe::prepareAuthenticatedData(const std::string& data, const std::string& hexKey, const std::string& clientId, const std::string& ivec)
 {
-    RSA::PublicKey publicKey;
-    bool rsaKeyValid = loadPublicKey(publicKeyPEM, publicKey);
-    if (!rsaKeyValid) {
-        throw std::invalid_argument("Could not load public key");
+    std::string iv;
+    if (!ivec.empty()) {
+        iv = Ripe::hexToString(ivec);
+        if (iv.size() != static_cast<std::size_t>(Ripe::AES_GCM_IV_SIZE)) {
+            throw std::invalid_argument("Invalid IV length for AES-GCM");
+        }
     }
-    std::string decodedSignature = Ripe::hexToString(signatureHex);
-    bool result = false;
-    RSASS<PKCS1v15,SHA1>::Verifier verifier(publicKey);
-    StringSource ss2(decodedSignature + data, true,
-                     new SignatureVerificationFilter(verifier,
-                                                     new ArraySink((RipeByte*)&result, sizeof(result))));
+    AESContext context(hexKey);
+    std::string result;
+    Ripe::prepareAuthenticatedData(data, context, result, clientId, iv.empty() ? nullptr : reinterpret_cast<const RipeByte*>(iv.data()));
     return result;
 }
 
-std::string Ripe::signRSA(const std::string& data, const std::string& privateKeyPEM, const std::string& privateKeySecret)
+std::size_t Ripe::prepareAuthenticatedData(const std::string& data, AESContext& context, std::string& output,
+                                           const std::string& clientId, const RipeByte* iv)
 {
-    RSA::PrivateKey privateKey;
-    bool rsaKeyValid = loadPrivateKey(privateKeyPEM, privateKey, privateKeySecret);
-    if (!rsaKeyValid) {
-        throw std::invalid_argument("Could not load private key");
+    RIPE_STATS_SCOPE(STATS_PACKET_PREPARE_AUTHENTICATED, data.size());
+    RipeByte ivArr[Ripe::AES_GCM_IV_SIZE];
+    if (iv == nullptr) {
+        generateRandom(ivArr, sizeof ivArr);
+    } else {
+        std::copy(iv, iv + Ripe::AES_GCM_IV_SIZE, ivArr);
     }
 
-    // sign message
-    std::string signature;
-    RSASS<PKCS1v15,SHA1>::Signer signer(privateKey);
-    AutoSeededRandomPool rng;
+    ScratchBuffer cipher(Ripe::expectedAESGCMCipherLength(data.size()));
+    context.encryptGCM(reinterpret_cast<const RipeByte*>(data.data()), data.size(), cipher.data(), cipher.size(), ivArr,
+                       reinterpret_cast<const RipeByte*>(clientId.data()), clientId.size());
 
-    StringSource ss(data, true,
-                    new SignerFilter(rng, signer,
-                                     new HexEncoder(
-                                         new StringSink(signature))));
-    return signature;
+    const std::size_t start = output.size();
+    output.resize(start + Ripe::expectedAuthenticatedDataSize(data.size(), clientId.size()));
+    char* end = writePacket(&output[start], ivArr, sizeof ivArr, clientId, cipher.data(), cipher.size());
+    output.resize(static_cast<std::size_t>(end - output.data()));
+    return output.size() - start;
 }
 
-bool Ripe::writeRSAKeyPair(const std::string& publicFile, const std::string& privateFile, int length, const std::string& secret)
+std::string Ripe::decryptAuthenticatedData(const std::string& data, AESContext& context, std::string& clientId)
 {
-    bool result = true;
-    KeyPair keypair = Ripe::generateRSAKeyPair(length, secret);
-    if (keypair.privateKey.size() > 0 && keypair.publicKey.size() > 0) {
-        std::ofstream fs(privateFile.c_str(), std::ios::out);
-        if (fs.is_open()) {
-            fs.write(keypair.privateKey.c_str(), keypair.privateKey.size());
-            fs.close();
-        } else {
-            throw std::runtime_error(
-                        std::string("Unable to open private file for writing [" + privateFile + "] " + std::strerror(errno)).data()
-                        );
-            result = false;
-        }
-        fs.open(publicFile.c_str(), std::ios::out);
-        if (fs.is_open()) {
-            fs.write(keypair.publicKey.c_str(), keypair.publicKey.size());
-            fs.close();
-            result = result && true;
-        } else {
-            throw std::runtime_error(
-                        std::string("Unable to open public file for writing [" + publicFile + "] " + std::strerror(errno)).data()
-                        );
-            result = false;
-        }
+    RIPE_STATS_SCOPE(STATS_PACKET_DECRYPT_AUTHENTICATED, data.size());
+    std::size_t end = data.size();
+    if (end >= PACKET_DELIMITER_SIZE && data.compare(end - PACKET_DELIMITER_SIZE, PACKET_DELIMITER_SIZE, PACKET_DELIMITER) == 0) {
+        end -= PACKET_DELIMITER_SIZE;
     }
-    if (!result) {
-        throw std::runtime_error("Failed to generate key pair.");
+    const std::size_t ivHexSize = Ripe::AES_GCM_IV_SIZE * 2;
+    std::size_t pos = data.find(Ripe::DATA_DELIMITER);
+    RipeByte iv[Ripe::AES_GCM_IV_SIZE];
+    if (pos != ivHexSize || pos > end
+            || Ripe::hexToString(reinterpret_cast<const RipeByte*>(data.data()), ivHexSize, iv, sizeof iv) != sizeof iv) {
+        throw std::invalid_argument("Invalid authenticated data, expected [IV]:[[Client_ID]:]:[Base64 Data]");
+    }
+    std::size_t payloadStart = pos + 1;
+    pos = data.find(Ripe::DATA_DELIMITER, payloadStart);
+    if (pos != std::string::npos && pos < end) {
+        clientId.assign(data, payloadStart, pos - payloadStart);
+        payloadStart = pos + 1;
+    } else {
+        clientId.clear();
+    }
+
+    const std::size_t base64Size = end - payloadStart;
+    ScratchBuffer cipher(Ripe::maxBase64DecodedLength(base64Size));
+    cipher.resize(Ripe::base64Decode(reinterpret_cast<const RipeByte*>(data.data()) + payloadStart, base64Size, cipher.data(), cipher.size()));
+    if (cipher.size() < static_cast<std::size_t>(Ripe::AES_GCM_TAG_SIZE)) {
+        throw InvalidCiphertext("AES-GCM: cipher is too short");
     }
+
+    std::string result(cipher.size() - Ripe::AES_GCM_TAG_SIZE, '\0');
+    context.decryptGCM(cipher.data(), cipher.size(), reinterpret_cast<RipeByte*>(&result[0]), result.size(), iv,
+                       reinterpret_cast<const RipeByte*>(clientId.data()), clientId.size());
     return result;
 }
 
-std::string Ripe::generateRSAKeyPairBase64(int length, const std::string& secret)
+std::string Ripe::decryptAuthenticatedData(const std::string& data, const std::string& hexKey)
 {
-    Ripe::KeyPair pair = Ripe::generateRSAKeyPair(length, secret);
-    if (pair.privateKey.empty() || pair.publicKey.empty()) {
-        throw std::runtime_error("Failed to generate key pair.");
-    }
-    return Ripe::base64Encode(pair.privateKey) + ":" + Ripe::base64Encode(pair.publicKey);
+    AESContext context(hexKey);
+    std::string clientId;
+    return Ripe::decryptAuthenticatedData(data, context, clientId);
 }
 
-Ripe::KeyPair Ripe::generateRSAKeyPair(unsigned int length, const std::string& secret)
-{
-    AutoSeededRandomPool rng;
-    InvertibleRSAFunction params;
-    params.GenerateRandomWithKeySize(rng, length);
-    RSA::PrivateKey privateKey(params);
-    RSA::PublicKey publicKey(params);
+namespace {
 
-    Ripe::KeyPair pair;
-    {
-        StringSink snk(pair.privateKey);
-        if (secret.empty()) {
-            PEM_Save(snk, privateKey);
-        } else {
-            PEM_Save(snk, privateKey, rng, PRIVATE_RSA_ALGORITHM, secret.data(), secret.size());
-        }
-        snk.MessageEnd();
+// Binary packet header is version / mode byte followed by IV, client ID size takes 2 bytes and cipher size 4 bytes
+const std::size_t BINARY_CLIENT_ID_SIZE_BYTES = 2;
+const std::size_t BINARY_CIPHER_SIZE_BYTES = 4;
+
+std::size_t binaryIVSize(int mode)
+{
+    if (mode == Ripe::AES_CBC) {
+        return Ripe::AES_BLOCK_SIZE;
     }
-    {
-        StringSink snk(pair.publicKey);
-        PEM_Save(snk, publicKey);
-        snk.MessageEnd();
+    if (mode == Ripe::AES_GCM) {
+        return Ripe::AES_GCM_IV_SIZE;
     }
-    return pair;
+    throw std::invalid_argument("Binary packets only support AES_CBC and AES_GCM modes");
 }
 
-std::string Ripe::base64Encode(const std::string& input)
-{
-    std::string encoded;
-    StringSource ss(input, true, new Base64Encoder(
-                        new StringSink(encoded), false /* insert line breaks */)
-                    );
-    RIPE_UNUSED(ss);
-    return encoded;
-}
+} // namespace
 
-std::string Ripe::base64Decode(const std::string& base64Encoded)
+std::size_t Ripe::expectedBinaryDataSize(std::size_t plainDataSize, std::size_t clientIdSize, AESMode mode)
 {
-    std::string decoded;
-    StringSource ss(base64Encoded, true, new Base64Decoder(
-                        new StringSink(decoded))
-                    );
-    RIPE_UNUSED(ss);
-    return decoded;
+    return 1 + binaryIVSize(mode) + BINARY_CLIENT_ID_SIZE_BYTES + clientIdSize + BINARY_CIPHER_SIZE_BYTES
+            + (mode == AES_GCM ? expectedAESGCMCipherLength(plainDataSize) : expectedAESCipherLength(plainDataSize));
 }
 
-std::string Ripe::generateNewKey(int length)
+std::size_t Ripe::prepareBinaryData(const std::string& data, AESContext& context, std::string& output,
+                                    const std::string& clientId, AESMode mode, const RipeByte* iv)
 {
-    if (!(length == 16 || length == 24 || length == 32)) {
-        throw std::invalid_argument( "Invalid key length. Acceptable lengths are 16, 24 or 32" );
+    RIPE_STATS_SCOPE(STATS_PACKET_PREPARE_BINARY, data.size());
+    const std::size_t ivSize = binaryIVSize(mode);
+    if (clientId.size() > 0xFFFF) {
+        throw std::invalid_argument("Client ID of binary packet can not be longer than 65535 bytes");
     }
-    AutoSeededRandomPool rnd;
-    SecByteBlock key(length);
-    rnd.GenerateBlock(key, key.size());
-    std::string s;
-    HexEncoder hex(new StringSink(s));
-    hex.Put(key.data(), key.size());
-    hex.MessageEnd();
-    return s;
-}
-
-std::string Ripe::encryptAES(const std::string& buffer, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv)
-{
-    SecByteBlock keyBlock(key, keySize);
-
-    RipeByte ivArr[Ripe::AES_BLOCK_SIZE] = {0};
-
-    if (iv.empty()) {
-        AutoSeededRandomPool rnd;
-        rnd.GenerateBlock(ivArr, sizeof ivArr);
+    if (data.size() > 0xFFFFFFFF - Ripe::AES_BLOCK_SIZE) {
+        throw std::invalid_argument("Data of binary packet can not be larger than 4 GB");
+    }
+    const std::size_t start = output.size();
+    output.resize(start + Ripe::expectedBinaryDataSize(data.size(), clientId.size(), mode));
+    RipeByte* out = reinterpret_cast<RipeByte*>(&output[start]);
+    *out++ = static_cast<RipeByte>(BINARY_PACKET_VERSION << 4 | mode);
+    if (iv == nullptr) {
+        generateRandom(out, ivSize);
     } else {
-        for (std::size_t i = 0; i < iv.size(); ++i) {
-            ivArr[i] = iv.at(i);
-        }
+        std::copy(iv, iv + ivSize, out);
     }
+    const RipeByte* packetIv = out;
+    out += ivSize;
+    writeBigEndian(out, clientId.size(), BINARY_CLIENT_ID_SIZE_BYTES);
+    out = std::copy(clientId.begin(), clientId.end(), out + BINARY_CLIENT_ID_SIZE_BYTES);
 
-
-    std::string cipher;
-
-    CBC_Mode<AES>::Encryption e;
-    e.SetKeyWithIV(keyBlock, keyBlock.size(), ivArr);
-
-    if (iv.empty()) {
-        // store for user
-        iv.resize(sizeof ivArr);
-        std::copy(ivArr, ivArr + Ripe::AES_BLOCK_SIZE, iv.begin());
+    // Cipher is written in to output directly, its size is known before encryption
+    RipeByte* cipher = out + BINARY_CIPHER_SIZE_BYTES;
+    const std::size_t cipherCap = output.size() - static_cast<std::size_t>(cipher - reinterpret_cast<RipeByte*>(&output[0]));
+    std::size_t cipherSize;
+    try {
+        cipherSize = mode == AES_GCM
+                ? context.encryptGCM(reinterpret_cast<const RipeByte*>(data.data()), data.size(), cipher, cipherCap, packetIv,
+                                     reinterpret_cast<const RipeByte*>(clientId.data()), clientId.size())
+                : context.encrypt(reinterpret_cast<const RipeByte*>(data.data()), data.size(), cipher, cipherCap, packetIv);
+    } catch (...) {
+        output.resize(start);
+        throw;
     }
-
-    // The StreamTransformationFilter adds padding as required.
-    StringSource ss(buffer, true,
-                    new StreamTransformationFilter(e, new StringSink(cipher))
-                    );
-    RIPE_UNUSED(ss);
-    return cipher;
+    writeBigEndian(out, cipherSize, BINARY_CIPHER_SIZE_BYTES);
+    return output.size() - start;
 }
 
-std::string Ripe::encryptAES(std::string& data, const std::string& hexKey, const std::string& clientId, const std::string& outputFile, const std::string& ivec)
+std::string Ripe::prepareBinaryData(const std::string& data, const std::string& hexKey, const std::string& clientId,
+                                    AESMode mode, const std::string& ivec)
 {
-    std::stringstream ss;
-    if (!outputFile.empty()) {
-        std::vector<RipeByte> iv;
-        if (!ivec.empty()) {
-            RipeByte* ivBytes = reinterpret_cast<RipeByte*>(const_cast<char*>(ivec.data()));
-            iv = Ripe::RipeByteToVec(ivBytes);
-        }
-        std::string encrypted = Ripe::encryptAES(data, hexKey, iv);
-
-        std::ofstream out(outputFile.c_str());
-        out << encrypted.data();
-        out.close();
-        ss << "IV: " << std::hex << std::setfill('0');
-        for (std::vector<RipeByte>::const_iterator it = iv.begin(); it < iv.end(); ++it) {
-            ss << std::setw(2) << static_cast<unsigned int>(*it);
+    std::string iv;
+    if (!ivec.empty()) {
+        iv = Ripe::hexToString(ivec);
+        if (iv.size() != binaryIVSize(mode)) {
+            throw std::invalid_argument("Invalid IV length for binary packet");
         }
-        ss << std::endl;
-    } else {
-        ss << Ripe::prepareData(data, hexKey, clientId.c_str(), ivec);
     }
-    return ss.str();
-}
-
-std::string Ripe::decryptAES(const std::string& data, const RipeByte* key, std::size_t keySize, std::vector<RipeByte>& iv)
-{
+    AESContext context(hexKey);
     std::string result;
-    SecByteBlock keyBlock(key, keySize);
-
-    RipeByte ivArr[Ripe::AES_BLOCK_SIZE] = {0};
-    std::copy(iv.begin(), iv.end(), ivArr);
-
-    CBC_Mode<AES>::Decryption d;
-    d.SetKeyWithIV(keyBlock, keyBlock.size(), ivArr);
-
-    StringSource ss(data, true,
-                new StreamTransformationFilter( d, new StringSink(result))
-                );
-    RIPE_UNUSED(ss);
+    Ripe::prepareBinaryData(data, context, result, clientId, mode, iv.empty() ? nullptr : reinterpret_cast<const RipeByte*>(iv.data()));
     return result;
 }
 
-std::string Ripe::decryptAES(std::string& data, const std::string& hexKey, std::string& ivec, bool isBase64, bool isHex)
+std::size_t Ripe::binaryPacketSize(const RipeByte* data, std::size_t n)
 {
-    if (ivec.empty() && isBase64) {
-        // Extract IV from data
-        std::size_t pos = data.find_first_of(':');
-        if (pos == 32) {
-            ivec = data.substr(0, pos);
-            Ripe::normalizeHex(ivec);
-            data = data.substr(pos + 1);
-            pos = data.find_first_of(':');
-            if (pos != std::string::npos) {
-                // We ignore clientId which is = data.substr(0, pos);
-                data = data.substr(pos + 1);
-            }
-        }
+    if (n == 0) {
+        return 0;
     }
-    if (ivec.size() == 32) {
-        // Condensed form needs to be normalized
-        Ripe::normalizeHex(ivec);
+    if (data[0] >> 4 != BINARY_PACKET_VERSION) {
+        throw std::invalid_argument("Invalid binary packet, unsupported version");
     }
-
-    RipeByte* iv = reinterpret_cast<RipeByte*>(const_cast<char*>(ivec.data()));
-    std::vector<RipeByte> ivHex = Ripe::RipeByteToVec(iv);
-
-    if (isBase64) {
-        data = Ripe::base64Decode(data);
+    const std::size_t ivSize = binaryIVSize(data[0] & 0x0F);
+    std::size_t size = 1 + ivSize + BINARY_CLIENT_ID_SIZE_BYTES;
+    if (n < size) {
+        return 0;
     }
-    if (isHex) {
-        data = Ripe::hexToString(data);
+    size += static_cast<std::size_t>(readBigEndian(data + 1 + ivSize, BINARY_CLIENT_ID_SIZE_BYTES));
+    if (n < size + BINARY_CIPHER_SIZE_BYTES) {
+        return 0;
     }
-    return Ripe::decryptAES(data, reinterpret_cast<const RipeByte*>(Ripe::hexToString(hexKey).c_str()), hexKey.size() / 2, ivHex);
-}
-
-bool Ripe::compressFile(const std::string& gzFilename, const std::string& inputFile)
-{
-    gzFile out = gzopen(gzFilename.c_str(), "wb");
-    if (!out) {
-        throw std::runtime_error(
-                    std::string("Unable to open file for writing [" + gzFilename + "] " + std::strerror(errno)).data()
-                    );
-        return false;
-     }
-    char buff[BUFSIZ];
-    std::FILE* in = std::fopen(inputFile.c_str(), "rb");
-    std::size_t nRead = 0;
-    while((nRead = std::fread(buff, sizeof(char), BUFSIZ, in)) > 0) {
-        int RipeBytes_written = gzwrite(out, buff, nRead);
-        if (RipeBytes_written == 0) {
-           int err_no = 0;
-           throw std::runtime_error(
-                       std::string("Error during compression " + std::string(gzerror(out, &err_no))).data()
-                       );
-           gzclose(out);
-           return false;
-        }
-    }
-    gzclose(out);
-    std::fclose(in);
-    return true;
+    return size + BINARY_CIPHER_SIZE_BYTES + static_cast<std::size_t>(readBigEndian(data + size, BINARY_CIPHER_SIZE_BYTES));
 }
 
-std::string Ripe::compressString(const std::string& str)
+std::string Ripe::decryptBinaryData(const RipeByte* data, std::size_t n, AESContext& context, std::string& clientId)
 {
-    int compressionlevel = Z_BEST_COMPRESSION;
-    z_stream zs;
-    memset(&zs, 0, sizeof(zs));
+    RIPE_STATS_SCOPE(STATS_PACKET_DECRYPT_BINARY, n);
+    const std::size_t packetSize = Ripe::binaryPacketSize(data, n);
+    if (packetSize == 0 || packetSize != n) {
+        throw std::invalid_argument("Invalid binary packet, size does not match (expected single complete packet)");
+    }
+    const int mode = data[0] & 0x0F;
+    const RipeByte* iv = data + 1;
+    const std::size_t ivSize = binaryIVSize(mode);
+    const std::size_t clientIdSize = static_cast<std::size_t>(readBigEndian(iv + ivSize, BINARY_CLIENT_ID_SIZE_BYTES));
+    const RipeByte* clientIdData = iv + ivSize + BINARY_CLIENT_ID_SIZE_BYTES;
+    clientId.assign(reinterpret_cast<const char*>(clientIdData), clientIdSize);
+    const RipeByte* cipher = clientIdData + clientIdSize + BINARY_CIPHER_SIZE_BYTES;
+    const std::size_t cipherSize = n - static_cast<std::size_t>(cipher - data);
 
-    if (deflateInit(&zs, compressionlevel) != Z_OK) {
-        throw std::runtime_error("Unable to initialize zlib deflate");
+    std::string result;
+    if (mode == AES_GCM) {
+        if (cipherSize < static_cast<std::size_t>(Ripe::AES_GCM_TAG_SIZE)) {
+            throw InvalidCiphertext("AES-GCM: cipher is too short");
+        }
+        result.resize(cipherSize - Ripe::AES_GCM_TAG_SIZE);
+        context.decryptGCM(cipher, cipherSize, reinterpret_cast<RipeByte*>(&result[0]), result.size(), iv,
+                           clientIdData, clientIdSize);
+    } else {
+        result.resize(cipherSize);
+        result.resize(context.decrypt(cipher, cipherSize, reinterpret_cast<RipeByte*>(&result[0]), result.size(), iv));
     }
+    return result;
+}
 
-    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(str.data()));
-    zs.avail_in = str.size();
+std::string Ripe::decryptBinaryData(const std::string& data, AESContext& context, std::string& clientId)
+{
+    return Ripe::decryptBinaryData(reinterpret_cast<const RipeByte*>(data.data()), data.size(), context, clientId);
+}
 
-    int ret;
-    char outbuffer[ZLIB_BUFFER_SIZE];
-    std::string outstring;
+std::string Ripe::decryptBinaryData(const std::string& data, const std::string& hexKey)
+{
+    AESContext context(hexKey);
+    std::string clientId;
+    return Ripe::decryptBinaryData(data, context, clientId);
+}
 
-    // retrieve the compressed RipeBytes blockwise
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(outbuffer);
-        zs.avail_out = sizeof(outbuffer);
+struct Ripe::PacketDecoder::Impl
+{
+    std::string buffer;
+    // Bytes before consumed are packets already taken
+    std::size_t consumed;
+    // There is no delimiter that starts before scanned
+    std::size_t scanned;
+    std::size_t maxPacketSize;
+    std::vector<RipeByte> cipher;
+    Ripe::ScratchBuffer plain;
 
-        ret = deflate(&zs, Z_FINISH);
+    explicit Impl(std::size_t maxSize) :
+        consumed(0),
+        scanned(0),
+        maxPacketSize(maxSize),
+        plain(0, true)
+    {
+    }
 
-        if (outstring.size() < zs.total_out) {
-            outstring.append(outbuffer, zs.total_out - outstring.size());
+    void decrypt(const Packet& packet, AESContext& context)
+    {
+        cipher.resize(Ripe::maxBase64DecodedLength(packet.payloadSize));
+        cipher.resize(Ripe::base64Decode(reinterpret_cast<const RipeByte*>(packet.payload), packet.payloadSize,
+                                         cipher.data(), cipher.size()));
+        if (packet.ivSize == static_cast<std::size_t>(Ripe::AES_GCM_IV_SIZE) * 2) {
+            RipeByte iv[Ripe::AES_GCM_IV_SIZE];
+            if (Ripe::hexToString(reinterpret_cast<const RipeByte*>(packet.iv), packet.ivSize, iv, sizeof iv) != sizeof iv) {
+                throw std::invalid_argument("Invalid IV");
+            }
+            if (cipher.size() < static_cast<std::size_t>(Ripe::AES_GCM_TAG_SIZE)) {
+                throw InvalidCiphertext("AES-GCM: cipher is too short");
+            }
+            plain.resize(cipher.size() - Ripe::AES_GCM_TAG_SIZE);
+            context.decryptGCM(cipher.data(), cipher.size(), plain.data(), plain.size(), iv,
+                               reinterpret_cast<const RipeByte*>(packet.clientId), packet.clientIdSize);
+        } else {
+            AESIV iv;
+            if (!Ripe::parseIV(packet.iv, packet.ivSize, iv)) {
+                throw std::invalid_argument("Invalid IV");
+            }
+            plain.resize(cipher.size());
+            plain.resize(context.decrypt(cipher.data(), cipher.size(), plain.data(), plain.size(), iv.data()));
         }
-    } while (ret == Z_OK);
-
-    deflateEnd(&zs);
-
-    if (ret != Z_STREAM_END) {
-        std::ostringstream oss;
-        oss << "Exception during zlib compression: (" << ret << ") " << (zs.msg != NULL ? zs.msg : "no msg");
-        throw std::runtime_error(oss.str());
     }
+};
 
-    return outstring;
-}
-
-std::string Ripe::decompressString(const std::string& str)
+Ripe::PacketDecoder::PacketDecoder(std::size_t maxPacketSize) :
+    m_impl(new Impl(maxPacketSize))
 {
-    z_stream zs;
-    memset(&zs, 0, sizeof(zs));
+}
 
-    if (inflateInit(&zs) != Z_OK) {
-        throw std::runtime_error("Unable to initialize zlib inflate");
-    }
+Ripe::PacketDecoder::PacketDecoder(PacketDecoder&&) = default;
 
-    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(str.data()));
-    zs.avail_in = str.size();
+Ripe::PacketDecoder& Ripe::PacketDecoder::operator=(PacketDecoder&&) = default;
 
-    int ret;
-    char outbuffer[ZLIB_BUFFER_SIZE];
-    std::string outstring;
+Ripe::PacketDecoder::~PacketDecoder()
+{
+}
 
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(outbuffer);
-        zs.avail_out = sizeof(outbuffer);
+void Ripe::PacketDecoder::feed(const char* data, std::size_t n)
+{
+    // Taken packets are dropped here (and not in next) so views stay valid until next feed
+    if (m_impl->consumed > 0) {
+        m_impl->buffer.erase(0, m_impl->consumed);
+        m_impl->scanned -= m_impl->consumed;
+        m_impl->consumed = 0;
+    }
+    m_impl->buffer.append(data, n);
+}
 
-        ret = inflate(&zs, 0);
+void Ripe::PacketDecoder::feed(const std::string& data)
+{
+    feed(data.data(), data.size());
+}
 
-        if (outstring.size() < zs.total_out) {
-            outstring.append(outbuffer, zs.total_out - outstring.size());
+bool Ripe::PacketDecoder::next(Packet& packet)
+{
+    const std::string& buffer = m_impl->buffer;
+    const std::size_t start = m_impl->consumed;
+    const std::size_t end = buffer.find(PACKET_DELIMITER, std::max(start, m_impl->scanned));
+    if (end == std::string::npos) {
+        if (buffer.size() - start > m_impl->maxPacketSize) {
+            clear();
+            throw std::invalid_argument("Packet exceeds maximum packet size");
         }
+        // Delimiter may still complete with next feed
+        m_impl->scanned = std::max(start, buffer.size() - std::min(buffer.size(), PACKET_DELIMITER_SIZE - 1));
+        return false;
+    }
+    m_impl->consumed = end + PACKET_DELIMITER_SIZE;
+    m_impl->scanned = m_impl->consumed;
 
-    } while (ret == Z_OK);
-
-    inflateEnd(&zs);
-
-    if (ret != Z_STREAM_END) {
-        std::ostringstream oss;
-        oss << "Exception during zlib decompression: (" << ret << ") " << (zs.msg != NULL ? zs.msg : "no msg");
-        throw std::runtime_error(oss.str());
+    const char* data = buffer.data() + start;
+    const std::size_t size = end - start;
+    const char* ivEnd = static_cast<const char*>(memchr(data, Ripe::DATA_DELIMITER, size));
+    if (ivEnd == nullptr || ivEnd == data) {
+        throw std::invalid_argument("Invalid packet, expected [IV]:[[Client_ID]:]:[Base64 Data]");
+    }
+    packet.iv = data;
+    packet.ivSize = static_cast<std::size_t>(ivEnd - data);
+    const char* rest = ivEnd + 1;
+    const std::size_t restSize = size - packet.ivSize - 1;
+    const char* clientIdEnd = static_cast<const char*>(memchr(rest, Ripe::DATA_DELIMITER, restSize));
+    if (clientIdEnd != nullptr) {
+        packet.clientId = rest;
+        packet.clientIdSize = static_cast<std::size_t>(clientIdEnd - rest);
+        packet.payload = clientIdEnd + 1;
+        packet.payloadSize = restSize - packet.clientIdSize - 1;
+    } else {
+        packet.clientId = rest;
+        packet.clientIdSize = 0;
+        packet.payload = rest;
+        packet.payloadSize = restSize;
     }
+    return true;
+}
 
-    return outstring;
+std::size_t Ripe::PacketDecoder::decrypt(const Packet& packet, AESContext& context, std::string& output)
+{
+    RIPE_STATS_SCOPE(STATS_PACKET_DECODE, packet.payloadSize);
+    m_impl->decrypt(packet, context);
+    output.append(reinterpret_cast<const char*>(m_impl->plain.data()), m_impl->plain.size());
+    return m_impl->plain.size();
 }
 
-std::string Ripe::sha256Hash(const std::string& data)
+std::size_t Ripe::PacketDecoder::decryptAll(AESContext& context, const std::function<void(const Packet&, const RipeByte*, std::size_t)>& fn)
 {
-    std::string digest;
-    SHA256 hasher;
-    StringSource ss(data, true, new HashFilter(hasher, new HexEncoder(new StringSink(digest))));
-    return digest;
+    std::size_t count = 0;
+    Packet packet;
+    while (next(packet)) {
+        m_impl->decrypt(packet, context);
+        fn(packet, m_impl->plain.data(), m_impl->plain.size());
+        ++count;
+    }
+    return count;
 }
 
-std::string Ripe::sha512Hash(const std::string& data)
+std::size_t Ripe::PacketDecoder::buffered() const
 {
-    std::string digest;
-    CryptoPP::SHA512 hasher;
-    StringSource ss(data, true, new HashFilter(hasher, new HexEncoder(new StringSink(digest))));
-    return digest;
+    return m_impl->buffer.size() - m_impl->consumed;
 }
 
-std::string Ripe::prepareData(const std::string& data, const std::string& hexKey, const char* clientId, const std::string& ivec)
+void Ripe::PacketDecoder::clear()
 {
-    std::vector<RipeByte> iv;
-    if (!ivec.empty()) {
-        std::string ivector(ivec);
-        if (ivector.size() == 32) {
-            Ripe::normalizeHex(ivector);
-        }
-        RipeByte* ivBytes = reinterpret_cast<RipeByte*>(const_cast<char*>(ivector.data()));
-        iv = Ripe::RipeByteToVec(ivBytes);
-    }
-    std::string encrypted = Ripe::encryptAES(data, hexKey, iv);
-    // Encryption Base64 encoding
-    std::string base64Encoded = Ripe::base64Encode(encrypted);
+    m_impl->buffer.clear();
+    m_impl->consumed = 0;
+    m_impl->scanned = 0;
+}
 
-    // IV Hex
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (std::vector<RipeByte>::const_iterator it = iv.begin(); it < iv.end(); ++it) {
-        ss << std::setw(2) << static_cast<unsigned int>(*it);
+std::size_t Ripe::prepareDataBatch(const std::vector<std::string>& data, AESContext& context, std::string& output,
+                                   const std::string& clientId)
+{
+    const std::size_t start = output.size();
+    std::size_t totalSize = 0;
+    for (std::vector<std::string>::const_iterator it = data.begin(); it != data.end(); ++it) {
+        totalSize += Ripe::expectedDataSize(it->size(), clientId.size());
     }
-    ss << Ripe::DATA_DELIMITER;
-    if (strlen(clientId) > 0) {
-        ss << clientId << Ripe::DATA_DELIMITER;
+    output.reserve(start + totalSize);
+    for (std::vector<std::string>::const_iterator it = data.begin(); it != data.end(); ++it) {
+        Ripe::prepareData(*it, context, output, clientId);
     }
-    ss << base64Encoded;
-    std::stringstream fss;
-    fss << ss.str() << PACKET_DELIMITER;
-    return fss.str();
+    return output.size() - start;
+}
+
+std::string Ripe::prepareDataBatch(const std::vector<std::string>& data, const std::string& hexKey, const std::string& clientId)
+{
+    AESContext context(hexKey);
+    std::string result;
+    Ripe::prepareDataBatch(data, context, result, clientId);
+    return result;
 }
 
 bool Ripe::normalizeHex(std::string& iv)
@@ -568,6 +4236,44 @@ bool Ripe::normalizeHex(std::string& iv)
     return false;
 }
 
+bool Ripe::parseIV(const char* hex, std::size_t n, AESIV& iv)
+{
+    AESIV parsed;
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n;) {
+        if (hex[i] == ' ' || hex[i] == '\t') {
+            ++i;
+            continue;
+        }
+        if (count == parsed.size() || i + 1 == n || hexValue(hex[i]) < 0 || hexValue(hex[i + 1]) < 0) {
+            return false;
+        }
+        parsed[count++] = static_cast<RipeByte>((hexValue(hex[i]) << 4) | hexValue(hex[i + 1]));
+        i += 2;
+    }
+    if (count != parsed.size()) {
+        return false;
+    }
+    iv = parsed;
+    return true;
+}
+
+void Ripe::formatIV(const AESIV& iv, char* out)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    for (AESIV::const_iterator it = iv.begin(); it != iv.end(); ++it) {
+        *out++ = HEX_DIGITS[*it >> 4];
+        *out++ = HEX_DIGITS[*it & 0x0f];
+    }
+}
+
+std::string Ripe::ivToString(const AESIV& iv)
+{
+    char buffer[32];
+    formatIV(iv, buffer);
+    return std::string(buffer, sizeof buffer);
+}
+
 std::string Ripe::vecToString(const std::vector<RipeByte>& iv)
 {
     std::stringstream ss;
@@ -593,28 +4299,38 @@ std::vector<RipeByte> Ripe::RipeByteToVec(const RipeByte* b)
 
 std::string Ripe::hexToString(const std::string& hex)
 {
-    std::string result;
-    StringSource ss(hex, true,
-        new HexDecoder(
-            new StringSink(result)
-        )
-    );
-    RIPE_UNUSED(ss);
+    std::string result(hex.size() / 2, '\0');
+    result.resize(Ripe::hexToString(reinterpret_cast<const RipeByte*>(hex.data()), hex.size(),
+                                    reinterpret_cast<RipeByte*>(&result[0]), result.size()));
     return result;
 }
 
+std::size_t Ripe::hexToString(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap)
+{
+    RIPE_STATS_SCOPE(STATS_HEX_DECODE, n);
+    if (outCap < n / 2) {
+        throw std::invalid_argument("Output buffer too small for hex decoding");
+    }
+    return RipeCodec::hexDecode(in, n, out);
+}
+
 std::string Ripe::stringToHex(const std::string& raw)
 {
-    std::string result;
-    StringSource ss(raw, true,
-        new HexEncoder(
-            new StringSink(result)
-        )
-    );
-    RIPE_UNUSED(ss);
+    std::string result(raw.size() * 2, '\0');
+    Ripe::stringToHex(reinterpret_cast<const RipeByte*>(raw.data()), raw.size(),
+                      reinterpret_cast<RipeByte*>(&result[0]), result.size());
     return result;
 }
 
+std::size_t Ripe::stringToHex(const RipeByte* in, std::size_t n, RipeByte* out, std::size_t outCap)
+{
+    RIPE_STATS_SCOPE(STATS_HEX_ENCODE, n);
+    if (outCap < n * 2) {
+        throw std::invalid_argument("Output buffer too small for hex encoding");
+    }
+    return RipeCodec::hexEncode(in, n, out);
+}
+
 std::size_t Ripe::expectedDataSize(std::size_t plainDataSize, std::size_t clientIdSize)
 {
     std::size_t dataSize = 32 /* IV */
@@ -624,7 +4340,85 @@ std::size_t Ripe::expectedDataSize(std::size_t plainDataSize, std::size_t client
     return dataSize + PACKET_DELIMITER_SIZE;
 }
 
+std::size_t Ripe::expectedAuthenticatedDataSize(std::size_t plainDataSize, std::size_t clientIdSize)
+{
+    std::size_t dataSize = AES_GCM_IV_SIZE * 2 /* IV */
+            + sizeof(DATA_DELIMITER) /* : */
+            + (clientIdSize > 0 ? clientIdSize + sizeof(DATA_DELIMITER) : 0)
+            + expectedBase64Length(expectedAESGCMCipherLength(plainDataSize));
+    return dataSize + PACKET_DELIMITER_SIZE;
+}
+
 std::string Ripe::version()
 {
     return RIPE_VERSION;
 }
+
+Ripe::CPUFeatures Ripe::cpuFeatures()
+{
+    CPUFeatures result;
+#if defined(__x86_64__) || defined(_M_X64)
+    result.architecture = "x86_64";
+#elif defined(__i386__) || defined(_M_IX86)
+    result.architecture = "x86";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    result.architecture = "aarch64";
+#elif defined(__arm__) || defined(_M_ARM)
+    result.architecture = "arm";
+#else
+    result.architecture = "unknown";
+#endif
+
+#if defined(RIPE_CPUID)
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        if (ecx & (1U << 25)) {
+            result.features.push_back("aes");
+        }
+        if (ecx & (1U << 1)) {
+            result.features.push_back("pclmul");
+        }
+    }
+    if (__get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if (ebx & (1U << 29)) {
+            result.features.push_back("sha");
+        }
+    }
+    // These also need OS support (saved AVX state) which cpu builtins check
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) {
+        result.features.push_back("ssse3");
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        result.features.push_back("sse4.1");
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        result.features.push_back("avx2");
+    }
+#elif defined(RIPE_AUXV)
+    // Bits of AT_HWCAP from asm/hwcap.h
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    const char* const names[] = { "aes", "pmull", "sha1", "sha2", "sha512", "neon" };
+    const unsigned long bits[] = { 1UL << 3, 1UL << 4, 1UL << 5, 1UL << 6, 1UL << 21, 1UL << 1 };
+    for (std::size_t i = 0; i < sizeof bits / sizeof bits[0]; ++i) {
+        if (hwcap & bits[i]) {
+            result.features.push_back(names[i]);
+        }
+    }
+#elif defined(__aarch64__) && defined(__APPLE__)
+    // Every Apple ARM processor has these
+    const char* const names[] = { "aes", "pmull", "sha1", "sha2", "neon" };
+    result.features.assign(names, names + sizeof names / sizeof names[0]);
+#endif
+
+#if CRYPTOPP_VERSION >= 600
+    // Crypto++ selects its implementation when it is first used, these report the selected one
+    result.aes = CryptoPP::AES::Encryption().AlgorithmProvider();
+    result.gcm = CryptoPP::GCM<CryptoPP::AES>::Encryption().AlgorithmProvider();
+    result.sha256 = CryptoPP::SHA256().AlgorithmProvider();
+    result.sha512 = CryptoPP::SHA512().AlgorithmProvider();
+#endif
+    result.codec = RipeCodec::implementation();
+    return result;
+}
@@ -0,0 +1,583 @@
+//
+//  Ripe
+//
+//  Copyright 2017-present Amrayn Web Services
+//
+//  https://muflihun.com
+//  https://amrayn.com
+//  https://github.com/amrayn/ripe
+//
+//  Author: @abumusamq
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <cstdint>
+#include <cstring>
+
+#include "RipeCodec.h"
+
+// Vectorized codecs are compiled with per-function target attributes so rest of the library
+// does not need any special compiler flags. Define RIPE_NO_SIMD to only build scalar codecs.
+#if !defined(RIPE_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#   define RIPE_CODEC_X86
+#   include <immintrin.h>
+#   define RIPE_TARGET(t) __attribute__((target(t)))
+#elif !defined(RIPE_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#   define RIPE_CODEC_NEON
+#   include <arm_neon.h>
+#endif
+
+namespace {
+
+const RipeByte BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+const RipeByte HEX_ALPHABET[] = "0123456789ABCDEF";
+const RipeByte INVALID = 0xFF;
+
+// Six-bit value of each base64 character, INVALID if character is not part of alphabet
+const RipeByte BASE64_VALUES[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// Four-bit value of each (upper or lower case) hexadecimal character, INVALID otherwise
+const RipeByte HEX_VALUES[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// Scalar decoders run for at least this many characters after vectorized decoder stops
+// at a block with characters outside alphabet (e.g, line breaks or padding)
+const std::size_t SCALAR_RUN_SIZE = 64;
+
+///
+/// \brief Vectorized kernels only process complete blocks and return number of input bytes they consumed,
+/// decoders stop at first block that has any character outside alphabet.
+/// Rest of the input (and everything else) is handled by scalar code.
+///
+struct CodecKernels
+{
+    const char* name;
+    std::size_t (*base64Encode)(const RipeByte* in, std::size_t n, RipeByte* out);
+    std::size_t (*base64Decode)(const RipeByte* in, std::size_t n, RipeByte* out);
+    std::size_t (*hexEncode)(const RipeByte* in, std::size_t n, RipeByte* out);
+    std::size_t (*hexDecode)(const RipeByte* in, std::size_t n, RipeByte* out);
+};
+
+#if defined(RIPE_CODEC_X86)
+
+// Base64 with SSSE3 / AVX2 is based on algorithms by Wojciech Mula and Daniel Lemire
+// (http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html)
+
+RIPE_TARGET("ssse3") inline __m128i base64EncodeBlockSSSE3(__m128i in)
+{
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(t0, t1);
+    // Map each six-bit index to offset from its character
+    __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    const __m128i shifts = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                         '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(shifts, offsets), indices);
+}
+
+RIPE_TARGET("ssse3") std::size_t base64EncodeSSSE3(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    std::size_t i = 0;
+    // Each block loads 16 bytes but only encodes 12
+    for (; n - i >= 16; i += 12, out += 16) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                         base64EncodeBlockSSSE3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+    }
+    return i;
+}
+
+// Returns false if any character is outside alphabet, otherwise sets six-bit values
+RIPE_TARGET("ssse3") inline bool base64ValuesSSSE3(__m128i in, __m128i& values)
+{
+    const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    const __m128i loNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+    const __m128i loFlags = _mm_shuffle_epi8(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A), loNibbles);
+    const __m128i hiFlags = _mm_shuffle_epi8(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10), hiNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(loFlags, hiFlags), _mm_setzero_si128())) != 0xFFFF) {
+        return false;
+    }
+    const __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    const __m128i shifts = _mm_shuffle_epi8(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0),
+                                            _mm_add_epi8(slash, hiNibbles));
+    values = _mm_add_epi8(in, shifts);
+    return true;
+}
+
+// Packs 16 six-bit values in to 12 bytes (in lower 12 bytes of result)
+RIPE_TARGET("ssse3") inline __m128i base64PackSSSE3(__m128i values)
+{
+    const __m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+RIPE_TARGET("ssse3") std::size_t base64DecodeSSSE3(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    std::size_t i = 0;
+    __m128i values;
+    for (; n - i >= 16; i += 16, out += 12) {
+        if (!base64ValuesSSSE3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), values)) {
+            break;
+        }
+        const __m128i decoded = base64PackSSSE3(values);
+        if (n - i >= 24) {
+            // Output has room for all 16 bytes as long as there is more input after this block
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), decoded);
+        } else {
+            RipeByte block[16];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(block), decoded);
+            std::memcpy(out, block, 12);
+        }
+    }
+    return i;
+}
+
+RIPE_TARGET("ssse3") std::size_t hexEncodeSSSE3(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const __m128i alphabet = _mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_ALPHABET));
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    std::size_t i = 0;
+    for (; n - i >= 16; i += 16, out += 32) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i hi = _mm_shuffle_epi8(alphabet, _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+        const __m128i lo = _mm_shuffle_epi8(alphabet, _mm_and_si128(bytes, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+// Returns false if any character is not hexadecimal, otherwise sets pairs of nibbles merged in to 16-bit lanes
+RIPE_TARGET("ssse3") inline bool hexValuesSSSE3(__m128i in, __m128i& values)
+{
+    const __m128i digits = _mm_sub_epi8(in, _mm_set1_epi8('0'));
+    const __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+    const __m128i letters = _mm_sub_epi8(_mm_or_si128(in, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)), letters);
+    if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xFFFF) {
+        return false;
+    }
+    const __m128i nibbles = _mm_or_si128(_mm_and_si128(isDigit, digits),
+                                         _mm_and_si128(isLetter, _mm_add_epi8(letters, _mm_set1_epi8(10))));
+    values = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+    return true;
+}
+
+RIPE_TARGET("ssse3") std::size_t hexDecodeSSSE3(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    std::size_t i = 0;
+    __m128i first;
+    __m128i second;
+    for (; n - i >= 32; i += 32, out += 16) {
+        if (!hexValuesSSSE3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), first)
+                || !hexValuesSSSE3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 16)), second)) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(first, second));
+    }
+    return i;
+}
+
+// AVX2 versions run same algorithms on both 128-bit lanes
+
+RIPE_TARGET("avx2") inline __m256i broadcast(__m128i lane)
+{
+    return _mm256_broadcastsi128_si256(lane);
+}
+
+RIPE_TARGET("avx2") std::size_t base64EncodeAVX2(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const __m256i shuffle = broadcast(_mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m256i shifts = broadcast(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                   '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+    std::size_t i = 0;
+    // Each lane loads 16 bytes but only encodes 12 so second lane reads 4 bytes past the block
+    for (; n - i >= 28; i += 24, out += 32) {
+        __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))),
+                                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12)), 1);
+        bytes = _mm256_shuffle_epi8(bytes, shuffle);
+        const __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        const __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t0, t1);
+        __m256i offsets = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        offsets = _mm256_or_si256(offsets, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_add_epi8(_mm256_shuffle_epi8(shifts, offsets), indices));
+    }
+    return i;
+}
+
+RIPE_TARGET("avx2") std::size_t base64DecodeAVX2(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const __m256i loLookup = broadcast(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                     0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A));
+    const __m256i hiLookup = broadcast(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                     0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+    const __m256i shiftLookup = broadcast(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+    const __m256i pack = broadcast(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    std::size_t i = 0;
+    for (; n - i >= 32; i += 32, out += 24) {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(chars, 4), mask);
+        const __m256i flags = _mm256_and_si256(_mm256_shuffle_epi8(loLookup, _mm256_and_si256(chars, mask)),
+                                               _mm256_shuffle_epi8(hiLookup, hiNibbles));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(flags, _mm256_setzero_si256())) != -1) {
+            break;
+        }
+        const __m256i slash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+        const __m256i values = _mm256_add_epi8(chars, _mm256_shuffle_epi8(shiftLookup, _mm256_add_epi8(slash, hiNibbles)));
+        __m256i decoded = _mm256_madd_epi16(_mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+        decoded = _mm256_shuffle_epi8(decoded, pack);
+        // Move 12 bytes of each lane next to each other
+        decoded = _mm256_permutevar8x32_epi32(decoded, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        if (n - i >= 48) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), decoded);
+        } else {
+            RipeByte block[32];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(block), decoded);
+            std::memcpy(out, block, 24);
+        }
+    }
+    return i;
+}
+
+RIPE_TARGET("avx2") std::size_t hexEncodeAVX2(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const __m256i alphabet = broadcast(_mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_ALPHABET)));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    std::size_t i = 0;
+    for (; n - i >= 32; i += 32, out += 64) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        const __m256i hi = _mm256_shuffle_epi8(alphabet, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), mask));
+        const __m256i lo = _mm256_shuffle_epi8(alphabet, _mm256_and_si256(bytes, mask));
+        // Unpacking works within lanes, i.e, first has bytes 0-7 and 16-23, second has 8-15 and 24-31
+        const __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        const __m256i second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return i;
+}
+
+RIPE_TARGET("avx2") inline bool hexValuesAVX2(__m256i in, __m256i& values)
+{
+    const __m256i digits = _mm256_sub_epi8(in, _mm256_set1_epi8('0'));
+    const __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+    const __m256i letters = _mm256_sub_epi8(_mm256_or_si256(in, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    const __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(letters, _mm256_set1_epi8(5)), letters);
+    if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isLetter)) != -1) {
+        return false;
+    }
+    const __m256i nibbles = _mm256_or_si256(_mm256_and_si256(isDigit, digits),
+                                            _mm256_and_si256(isLetter, _mm256_add_epi8(letters, _mm256_set1_epi8(10))));
+    values = _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+    return true;
+}
+
+RIPE_TARGET("avx2") std::size_t hexDecodeAVX2(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    std::size_t i = 0;
+    __m256i first;
+    __m256i second;
+    for (; n - i >= 64; i += 64, out += 32) {
+        if (!hexValuesAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), first)
+                || !hexValuesAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 32)), second)) {
+            break;
+        }
+        // Packing works within lanes so 64-bit quarters need re-ordering
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xD8));
+    }
+    return i;
+}
+
+#elif defined(RIPE_CODEC_NEON)
+
+uint8x16x4_t loadTable(const RipeByte* table)
+{
+    uint8x16x4_t result;
+    result.val[0] = vld1q_u8(table);
+    result.val[1] = vld1q_u8(table + 16);
+    result.val[2] = vld1q_u8(table + 32);
+    result.val[3] = vld1q_u8(table + 48);
+    return result;
+}
+
+std::size_t base64EncodeNEON(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const uint8x16x4_t alphabet = loadTable(BASE64_ALPHABET);
+    const uint8x16_t mask = vdupq_n_u8(0x3f);
+    std::size_t i = 0;
+    for (; n - i >= 48; i += 48, out += 64) {
+        // De-interleaves every three bytes and re-interleaves every four characters
+        const uint8x16x3_t bytes = vld3q_u8(in + i);
+        uint8x16x4_t chars;
+        chars.val[0] = vqtbl4q_u8(alphabet, vshrq_n_u8(bytes.val[0], 2));
+        chars.val[1] = vqtbl4q_u8(alphabet, vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[0], 4), vshrq_n_u8(bytes.val[1], 4)), mask));
+        chars.val[2] = vqtbl4q_u8(alphabet, vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[1], 2), vshrq_n_u8(bytes.val[2], 6)), mask));
+        chars.val[3] = vqtbl4q_u8(alphabet, vandq_u8(bytes.val[2], mask));
+        vst4q_u8(out, chars);
+    }
+    return i;
+}
+
+// Six-bit value of each character or INVALID (for characters >= 128 as well)
+inline uint8x16_t base64ValuesNEON(uint8x16_t chars, const uint8x16x4_t& lower, const uint8x16x4_t& upper)
+{
+    uint8x16_t values = vqtbl4q_u8(lower, chars);
+    values = vqtbx4q_u8(values, upper, vsubq_u8(chars, vdupq_n_u8(64)));
+    return vorrq_u8(values, vcgeq_u8(chars, vdupq_n_u8(128)));
+}
+
+std::size_t base64DecodeNEON(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const uint8x16x4_t lower = loadTable(BASE64_VALUES);
+    const uint8x16x4_t upper = loadTable(BASE64_VALUES + 64);
+    std::size_t i = 0;
+    for (; n - i >= 64; i += 64, out += 48) {
+        const uint8x16x4_t chars = vld4q_u8(in + i);
+        const uint8x16_t a = base64ValuesNEON(chars.val[0], lower, upper);
+        const uint8x16_t b = base64ValuesNEON(chars.val[1], lower, upper);
+        const uint8x16_t c = base64ValuesNEON(chars.val[2], lower, upper);
+        const uint8x16_t d = base64ValuesNEON(chars.val[3], lower, upper);
+        if (vmaxvq_u8(vorrq_u8(vorrq_u8(a, b), vorrq_u8(c, d))) > 0x3f) {
+            break;
+        }
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+        vst3q_u8(out, bytes);
+    }
+    return i;
+}
+
+std::size_t hexEncodeNEON(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const uint8x16_t alphabet = vld1q_u8(HEX_ALPHABET);
+    std::size_t i = 0;
+    for (; n - i >= 16; i += 16, out += 32) {
+        const uint8x16_t bytes = vld1q_u8(in + i);
+        uint8x16x2_t chars;
+        chars.val[0] = vqtbl1q_u8(alphabet, vshrq_n_u8(bytes, 4));
+        chars.val[1] = vqtbl1q_u8(alphabet, vandq_u8(bytes, vdupq_n_u8(0x0f)));
+        vst2q_u8(out, chars);
+    }
+    return i;
+}
+
+// Nibble value of each character, valid is set to all ones for hexadecimal characters
+inline uint8x16_t hexValuesNEON(uint8x16_t chars, uint8x16_t& valid)
+{
+    const uint8x16_t digits = vsubq_u8(chars, vdupq_n_u8('0'));
+    const uint8x16_t letters = vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    const uint8x16_t isDigit = vcleq_u8(digits, vdupq_n_u8(9));
+    valid = vorrq_u8(isDigit, vcleq_u8(letters, vdupq_n_u8(5)));
+    return vbslq_u8(isDigit, digits, vaddq_u8(letters, vdupq_n_u8(10)));
+}
+
+std::size_t hexDecodeNEON(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    std::size_t i = 0;
+    uint8x16_t hiValid;
+    uint8x16_t loValid;
+    for (; n - i >= 32; i += 32, out += 16) {
+        const uint8x16x2_t chars = vld2q_u8(in + i);
+        const uint8x16_t hi = hexValuesNEON(chars.val[0], hiValid);
+        const uint8x16_t lo = hexValuesNEON(chars.val[1], loValid);
+        if (vminvq_u8(vandq_u8(hiValid, loValid)) != 0xff) {
+            break;
+        }
+        vst1q_u8(out, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    }
+    return i;
+}
+
+#endif
+
+CodecKernels selectKernels()
+{
+#if defined(RIPE_CODEC_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        const CodecKernels avx2 = { "avx2", base64EncodeAVX2, base64DecodeAVX2, hexEncodeAVX2, hexDecodeAVX2 };
+        return avx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        const CodecKernels ssse3 = { "ssse3", base64EncodeSSSE3, base64DecodeSSSE3, hexEncodeSSSE3, hexDecodeSSSE3 };
+        return ssse3;
+    }
+#elif defined(RIPE_CODEC_NEON)
+    // NEON is part of AArch64 base line
+    const CodecKernels neon = { "neon", base64EncodeNEON, base64DecodeNEON, hexEncodeNEON, hexDecodeNEON };
+    return neon;
+#endif
+    const CodecKernels scalar = { "scalar", nullptr, nullptr, nullptr, nullptr };
+    return scalar;
+}
+
+const CodecKernels& kernels()
+{
+    // Selected once, initialization of function-local static is thread-safe
+    static const CodecKernels selected = selectKernels();
+    return selected;
+}
+
+} // namespace
+
+std::size_t RipeCodec::base64Encode(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const CodecKernels& k = kernels();
+    std::size_t i = k.base64Encode != nullptr ? k.base64Encode(in, n, out) : 0;
+    RipeByte* o = out + i / 3 * 4;
+    for (; n - i >= 3; i += 3) {
+        const std::uint32_t bits = (static_cast<std::uint32_t>(in[i]) << 16) | (static_cast<std::uint32_t>(in[i + 1]) << 8) | in[i + 2];
+        *o++ = BASE64_ALPHABET[bits >> 18];
+        *o++ = BASE64_ALPHABET[(bits >> 12) & 0x3f];
+        *o++ = BASE64_ALPHABET[(bits >> 6) & 0x3f];
+        *o++ = BASE64_ALPHABET[bits & 0x3f];
+    }
+    if (i < n) {
+        const std::size_t remaining = n - i;
+        const std::uint32_t bits = (static_cast<std::uint32_t>(in[i]) << 16) | (remaining == 2 ? static_cast<std::uint32_t>(in[i + 1]) << 8 : 0);
+        *o++ = BASE64_ALPHABET[bits >> 18];
+        *o++ = BASE64_ALPHABET[(bits >> 12) & 0x3f];
+        *o++ = remaining == 2 ? BASE64_ALPHABET[(bits >> 6) & 0x3f] : '=';
+        *o++ = '=';
+    }
+    return static_cast<std::size_t>(o - out);
+}
+
+std::size_t RipeCodec::base64Decode(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const CodecKernels& k = kernels();
+    RipeByte* o = out;
+    std::uint32_t bits = 0;
+    unsigned int count = 0;
+    std::size_t i = 0;
+    while (i < n) {
+        if (count == 0 && k.base64Decode != nullptr) {
+            const std::size_t consumed = k.base64Decode(in + i, n - i, o);
+            i += consumed;
+            o += consumed / 4 * 3;
+        }
+        // Characters outside alphabet are skipped; vectorized decoder is retried once
+        // a complete quantum is decoded after these
+        const std::size_t limit = n - i > SCALAR_RUN_SIZE ? i + SCALAR_RUN_SIZE : n;
+        for (; i < n && (i < limit || count != 0); ++i) {
+            const RipeByte value = BASE64_VALUES[in[i]];
+            if (value == INVALID) {
+                continue;
+            }
+            bits = (bits << 6) | value;
+            if (++count == 4) {
+                *o++ = static_cast<RipeByte>(bits >> 16);
+                *o++ = static_cast<RipeByte>(bits >> 8);
+                *o++ = static_cast<RipeByte>(bits);
+                bits = 0;
+                count = 0;
+            }
+        }
+    }
+    // Incomplete quantum only gives bytes it has all the bits for
+    if (count == 2) {
+        *o++ = static_cast<RipeByte>(bits >> 4);
+    } else if (count == 3) {
+        *o++ = static_cast<RipeByte>(bits >> 10);
+        *o++ = static_cast<RipeByte>(bits >> 2);
+    }
+    return static_cast<std::size_t>(o - out);
+}
+
+std::size_t RipeCodec::hexEncode(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const CodecKernels& k = kernels();
+    std::size_t i = k.hexEncode != nullptr ? k.hexEncode(in, n, out) : 0;
+    for (RipeByte* o = out + i * 2; i < n; ++i) {
+        *o++ = HEX_ALPHABET[in[i] >> 4];
+        *o++ = HEX_ALPHABET[in[i] & 0x0f];
+    }
+    return n * 2;
+}
+
+std::size_t RipeCodec::hexDecode(const RipeByte* in, std::size_t n, RipeByte* out)
+{
+    const CodecKernels& k = kernels();
+    RipeByte* o = out;
+    RipeByte pending = 0;
+    bool hasPending = false;
+    std::size_t i = 0;
+    while (i < n) {
+        if (!hasPending && k.hexDecode != nullptr) {
+            const std::size_t consumed = k.hexDecode(in + i, n - i, o);
+            i += consumed;
+            o += consumed / 2;
+        }
+        const std::size_t limit = n - i > SCALAR_RUN_SIZE ? i + SCALAR_RUN_SIZE : n;
+        for (; i < n && (i < limit || hasPending); ++i) {
+            const RipeByte value = HEX_VALUES[in[i]];
+            if (value == INVALID) {
+                continue;
+            }
+            if (hasPending) {
+                *o++ = static_cast<RipeByte>((pending << 4) | value);
+            } else {
+                pending = value;
+            }
+            hasPending = !hasPending;
+        }
+    }
+    // Odd number of hexadecimal characters, last one is ignored
+    return static_cast<std::size_t>(o - out);
+}
+
+const char* RipeCodec::implementation()
+{
+    return kernels().name;
+}
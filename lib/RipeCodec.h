@@ -0,0 +1,60 @@
+//
+//  Ripe
+//
+//  Copyright 2017-present Amrayn Web Services
+//
+//  https://muflihun.com
+//  https://amrayn.com
+//  https://github.com/amrayn/ripe
+//
+//  Author: @abumusamq
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef RipeCodec_h
+#define RipeCodec_h
+
+#include <cstddef>
+
+#include "../include/Ripe.h"
+
+///
+/// \brief Built-in base64 and hexadecimal codecs used by Ripe
+///
+/// Each codec has a portable scalar implementation and vectorized (SSSE3 / AVX2 on x86, NEON on AArch64)
+/// implementations. Best implementation supported by the CPU is selected at runtime, once.
+/// All of them produce output identical to Crypto++ Base64Encoder (without line breaks), Base64Decoder,
+/// HexEncoder (upper-case) and HexDecoder, i.e, decoders skip characters that are not part of the alphabet
+/// (including padding) and ignore trailing bits that do not make a complete byte.
+///
+/// Callers must provide output buffers big enough (see Ripe::expectedBase64Length,
+/// Ripe::maxBase64DecodedLength, 2 * n and n / 2); these functions do not check capacity.
+///
+class RipeCodec {
+public:
+    static std::size_t base64Encode(const RipeByte* in, std::size_t n, RipeByte* out);
+    static std::size_t base64Decode(const RipeByte* in, std::size_t n, RipeByte* out);
+    static std::size_t hexEncode(const RipeByte* in, std::size_t n, RipeByte* out);
+    static std::size_t hexDecode(const RipeByte* in, std::size_t n, RipeByte* out);
+
+    ///
+    /// \brief Name of implementation selected for this CPU, e.g, avx2, ssse3, neon or scalar
+    ///
+    static const char* implementation();
+
+private:
+    RipeCodec();
+};
+
+#endif /* RipeCodec_h */
@@ -22,54 +22,104 @@
 //  limitations under the License.
 //
 
+#include <algorithm>
+#include <functional>
 #include <iomanip>
+#include <cstdint>
 #include <cstring>
-#include <sstream>
+#include <limits>
+#include <stdexcept>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "../include/Ripe.h"
+#include "server.h"
 
-void displayVersion()
+void displayVersion(bool verbose = false)
 {
     std::cout << "Ripe - Lightweight cryptography library wrapper" << std::endl << "Version: " << RIPE_VERSION << std::endl << "https://muflihun.com" << std::endl;
+    if (!verbose) {
+        return;
+    }
+    const Ripe::CPUFeatures cpu = Ripe::cpuFeatures();
+    std::cout << std::endl << "Architecture: " << cpu.architecture << std::endl << "CPU features:";
+    for (const std::string& feature : cpu.features) {
+        std::cout << " " << feature;
+    }
+    if (cpu.features.empty()) {
+        std::cout << " none detected";
+    }
+    std::cout << std::endl;
+    if (!cpu.aes.empty()) {
+        std::cout << "AES: " << cpu.aes << std::endl
+                  << "GCM: " << cpu.gcm << std::endl
+                  << "SHA-256: " << cpu.sha256 << std::endl
+                  << "SHA-512: " << cpu.sha512 << std::endl;
+    }
+    std::cout << "Base64 / hex: " << cpu.codec << std::endl;
 }
 
 void displayUsage()
 {
     // we want to keep the order so don't use std::map or std::unordered_map
     std::vector<std::pair<std::string, std::string> > options;
-    options.push_back(std::make_pair("--version", "Display version information"));
+    options.push_back(std::make_pair("--version", "Display version information (with --verbose, hardware acceleration in use)"));
     options.push_back(std::make_pair("-g", "Generate key"));
     options.push_back(std::make_pair("-e", "Encrypt / encode / inflate the data"));
     options.push_back(std::make_pair("-d", "Decrypt / decrypt / deflate the data"));
     options.push_back(std::make_pair("-s", "Sign the data"));
     options.push_back(std::make_pair("-v", "Verify the signed data"));
     options.push_back(std::make_pair("--aes", "Generate AES key (requires -g)"));
+    options.push_back(std::make_pair("--ed25519", "Generate Ed25519 key pair (requires -g)"));
     options.push_back(std::make_pair("--sha256", "Generate SHA-256 hash"));
     options.push_back(std::make_pair("--sha512", "Generate SHA-512 hash"));
+    options.push_back(std::make_pair("--blake2b", "Generate BLAKE2b hash"));
     options.push_back(std::make_pair("--hash", "Similar to --sha256"));
     options.push_back(std::make_pair("--key", "Symmetric key for encryption / decryption"));
     options.push_back(std::make_pair("--in-key", "Symmetric key for encryption / decryption file path"));
     options.push_back(std::make_pair("--iv", "Initializaion vector for decription"));
     options.push_back(std::make_pair("--rsa", "Use RSA encryption/decryption"));
-    options.push_back(std::make_pair("--zlib", "ZLib compression/decompression"));
+    options.push_back(std::make_pair("--envelope", "(With --rsa) Encrypt / decrypt data of any size using random AES key that is encrypted with RSA key"));
+    options.push_back(std::make_pair("--zlib", "ZLib compression/decompression, with --key data is compressed and encrypted (AES) in single pass"));
+    options.push_back(std::make_pair("--gzip", "(With --in and --out) Compress / decompress gzip file on multiple threads (--threads) without loading it in to memory"));
     options.push_back(std::make_pair("--raw", "Raw output for rsa encrypted data"));
     options.push_back(std::make_pair("--base64", "Tells ripe the data needs to be decoded before decryption (this can be used for decoding base64)"));
     options.push_back(std::make_pair("--hex", "Tells ripe the data is hex string"));
     options.push_back(std::make_pair("--clean", "(Only applicable when --base64 data provided) Tells ripe to clean the data before processing"));
     options.push_back(std::make_pair("--in", "Input file. You can also pipe in the data. In that case you do not have to provide this parameter"));
     options.push_back(std::make_pair("--out", "Tells ripe to store encrypted data in specified file. (Outputs IV in console)"));
+    options.push_back(std::make_pair("--aes-mode", "AES mode, cbc (default) or gcm (authenticated)"));
+    options.push_back(std::make_pair("--stream", "Encrypt / decrypt (AES) raw data from input to output in chunks with constant memory"));
+    options.push_back(std::make_pair("--threads", "Encrypt / decrypt (AES) in to chunked container using specified number of threads (0 = all cores)"));
+    options.push_back(std::make_pair("--scheme", "(With -s or -v) Signature scheme, rsa (PKCS #1 v1.5, SHA-1, default), rsa-pss (SHA-256) or ed25519"));
+    options.push_back(std::make_pair("--batch", "(With -s or -v) Sign / verify newline-delimited records, <signature>:<data> for verification. Uses --threads"));
+    options.push_back(std::make_pair("--each-line", "(With -e or -d) Encode / decode, hash or encrypt / decrypt (AES) every line separately, one result per line. Uses --threads, same as --batch"));
+    options.push_back(std::make_pair("--null", "(With --each-line) Records (input and output) are NUL-delimited instead of newline-delimited"));
+    options.push_back(std::make_pair("--binary", "(With -e or -d and --key) Encrypt in to / decrypt compact binary packet (AES-CBC or --aes-mode gcm) instead of text"));
+    options.push_back(std::make_pair("--serve", "Serve requests (encrypt, decrypt, sign, verify, hash, compress, decompress) on stdin / stdout or --socket with keys loaded once"));
+    options.push_back(std::make_pair("--socket", "(With --serve) Unix socket to listen on"));
+    options.push_back(std::make_pair("--in-private", "(With --serve) Private key file for sign requests"));
+    options.push_back(std::make_pair("--in-public", "(With --serve) Public key file for verify requests"));
+    options.push_back(std::make_pair("--stats", "Print statistics (JSON) of Ripe operations to stderr once done, requires ripe built with -Dstats=ON"));
     options.push_back(std::make_pair("--length", "Specify key length"));
     options.push_back(std::make_pair("--secret", "Secret key for encrypted private key (RSA only)"));
     options.push_back(std::make_pair("--sha256", "Generate SHA-256 hash"));
     options.push_back(std::make_pair("--sha512", "Generate SHA-512 hash"));
+    options.push_back(std::make_pair("--blake2b", "Generate BLAKE2b hash"));
     options.push_back(std::make_pair("--hash", "Similar to --sha256"));
 
     displayVersion();
     std::cout << "Usage: " << std::endl;
-    std::cout << "ripe [-d | -e | -g | -s | -v] [--in <input_file_path>] [--key <key>] [--in-key <file_path>] [--out-public <output_file_path>] [--out-private <output_file_path>] [--iv <init vector>] [--base64] [--rsa] [--length <key_length>] [--out <output_file_path>] [--clean] [--sha256 | --hash] [--sha512] [--aes [<key_length>]] [--secret] [--hex] [--signature]" << std::endl;
+    std::cout << "ripe [-d | -e | -g | -s | -v] [--in <input_file_path>] [--key <key>] [--in-key <file_path>] [--out-public <output_file_path>] [--out-private <output_file_path>] [--iv <init vector>] [--base64] [--rsa] [--length <key_length>] [--out <output_file_path>] [--clean] [--sha256 | --hash] [--sha512] [--blake2b] [--aes [<key_length>]] [--secret] [--hex] [--signature] [--aes-mode <cbc|gcm>] [--stream] [--threads <count>] [--batch] [--each-line [--null]] [--scheme <rsa|rsa-pss|ed25519>] [--ed25519] [--envelope] [--gzip] [--serve [--socket <path>] [--in-private <file>] [--in-public <file>]] [--stats]" << std::endl;
     std::cout << std::endl;
     const std::size_t LONGEST = 20;
     for (std::vector<std::pair<std::string, std::string> >::iterator it = options.begin();
@@ -87,6 +137,120 @@ void displayUsage()
 #define TRY try {
 #define CATCH }  catch (const std::exception& e) { std::cout << "ERROR: " << e.what() << std::endl; }
 
+// Reads everything from input in large blocks
+std::string readStream(std::istream& in)
+{
+    std::string result;
+    std::vector<char> buffer(Ripe::STREAM_CHUNK_SIZE);
+    while (in) {
+        in.read(buffer.data(), buffer.size());
+        result.append(buffer.data(), static_cast<std::size_t>(in.gcount()));
+    }
+    return result;
+}
+
+// Read-only contents of input file. Regular files are memory mapped so they are not copied,
+// anything else (pipe, device) is read in large blocks
+class InputFile {
+public:
+    explicit InputFile(const std::string& filename) :
+        m_mapped(nullptr),
+        m_size(0)
+    {
+#ifndef _WIN32
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open input file [" + filename + "]");
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+                && static_cast<std::uint64_t>(st.st_size) <= std::numeric_limits<std::size_t>::max()) {
+            void* mapped = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                m_mapped = mapped;
+                m_size = static_cast<std::size_t>(st.st_size);
+                madvise(m_mapped, m_size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+        if (m_mapped != nullptr) {
+            return;
+        }
+#endif
+        std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("Unable to open input file [" + filename + "]");
+        }
+        m_buffer = readStream(in);
+        if (in.bad()) {
+            throw std::runtime_error("Unable to read input file [" + filename + "]");
+        }
+        m_size = m_buffer.size();
+    }
+
+    ~InputFile()
+    {
+#ifndef _WIN32
+        if (m_mapped != nullptr) {
+            munmap(m_mapped, m_size);
+        }
+#endif
+    }
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    inline const char* data() const
+    {
+        return m_mapped != nullptr ? static_cast<const char*>(m_mapped) : m_buffer.data();
+    }
+
+    inline const RipeByte* bytes() const
+    {
+        return reinterpret_cast<const RipeByte*>(data());
+    }
+
+    inline std::size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    void* m_mapped;
+    std::size_t m_size;
+    std::string m_buffer;
+};
+
+// Output file (binary) or standard output if outputFile is empty
+std::ostream& openOutput(const std::string& outputFile, std::ofstream& file)
+{
+    if (outputFile.empty()) {
+        return std::cout;
+    }
+    file.open(outputFile.c_str(), std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open output file [" + outputFile + "]");
+    }
+    return file;
+}
+
+// Writes n bytes in one block (NUL bytes included)
+void writeOutput(const std::string& outputFile, const char* data, std::size_t n)
+{
+    std::ofstream file;
+    std::ostream& out = openOutput(outputFile, file);
+    out.write(data, static_cast<std::streamsize>(n));
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Unable to write output" + (outputFile.empty() ? std::string() : " file [" + outputFile + "]"));
+    }
+}
+
+inline void writeOutput(const std::string& outputFile, const std::string& data)
+{
+    writeOutput(outputFile, data.data(), data.size());
+}
+
 void encryptAES(std::string& data, const std::string& key,
                 const std::string& iv, const std::string& clientId,
                 const std::string& outputFile)
@@ -104,42 +268,193 @@ void decryptAES(std::string& data, const std::string& key,
     CATCH
 }
 
-void generateAESKey(int length)
+// Encrypts (CBC) mapped input straight in to output buffer that is written as one block
+void encryptAESToFile(const InputFile& input, const std::string& key, const std::string& iv,
+                      const std::string& outputFile)
 {
-    if (length == 0 || length == 2048) {
-        std::cout << "ERROR: Please provide valid key length" << std::endl;
-        return;
-    }
     TRY
-        std::cout << Ripe::generateNewKey(length / 8);
+        const std::string rawKey = Ripe::hexToString(key);
+        Ripe::AESIV rawIv;
+        if (iv.empty()) {
+            Ripe::parseIV(Ripe::generateNewKey(Ripe::AES_BLOCK_SIZE), rawIv);
+        } else if (!Ripe::parseIV(iv, rawIv)) {
+            throw std::invalid_argument("Invalid IV");
+        }
+        std::vector<RipeByte> cipher(Ripe::expectedAESCipherLength(input.size()));
+        const std::size_t length = Ripe::encryptAES(input.bytes(), input.size(), cipher.data(), cipher.size(),
+                                                    reinterpret_cast<const RipeByte*>(rawKey.data()), rawKey.size(), rawIv.data());
+        writeOutput(outputFile, reinterpret_cast<const char*>(cipher.data()), length);
+        std::cout << "IV: " << Ripe::ivToString(rawIv) << std::endl;
     CATCH
 }
 
-void encodeBase64(std::string& data)
+void encryptAESGCM(const std::string& data, const std::string& key,
+                   const std::string& iv, const std::string& clientId,
+                   const std::string& outputFile)
 {
     TRY
-        std::cout << Ripe::base64Encode(data);
+        writeOutput(outputFile, Ripe::prepareAuthenticatedData(data, key, clientId, iv));
     CATCH
 }
 
-void decodeBase64(std::string& data)
+void decryptAESGCM(std::string& data, const std::string& key,
+                   const std::string& iv, const std::string& clientId, bool isBase64,
+                   const std::string& outputFile)
 {
     TRY
-        std::cout << Ripe::base64Decode(data);
+        if (iv.empty()) {
+            // IV (and client ID) is part of the data
+            writeOutput(outputFile, Ripe::decryptAuthenticatedData(data, key));
+        } else {
+            if (isBase64) {
+                data = Ripe::base64Decode(data);
+            }
+            const std::string rawKey = Ripe::hexToString(key);
+            const std::string rawIv = Ripe::hexToString(iv);
+            writeOutput(outputFile, Ripe::decryptAESGCM(data, reinterpret_cast<const RipeByte*>(rawKey.data()), rawKey.size(),
+                                                        std::vector<RipeByte>(rawIv.begin(), rawIv.end()), clientId));
+        }
     CATCH
 }
 
-void encodeHex(std::string& data)
+// Raw data is encrypted in to one binary packet, for decryption input can have any number of packets
+// one after another. Input is not trimmed and output is written as is
+void binaryData(bool encrypt, const std::string& inputFile, const std::string& outputFile, const std::string& key,
+                const std::string& iv, const std::string& clientId, bool gcm)
 {
     TRY
-        std::cout << Ripe::stringToHex(data);
+        std::unique_ptr<InputFile> input;
+        std::string data;
+        if (!inputFile.empty()) {
+            input.reset(new InputFile(inputFile));
+        } else {
+            data = readStream(std::cin);
+        }
+        const RipeByte* in = input ? input->bytes() : reinterpret_cast<const RipeByte*>(data.data());
+        const std::size_t size = input ? input->size() : data.size();
+        if (encrypt) {
+            if (input) {
+                data.assign(input->data(), input->size());
+            }
+            writeOutput(outputFile, Ripe::prepareBinaryData(data, key, clientId, gcm ? Ripe::AES_GCM : Ripe::AES_CBC, iv));
+            return;
+        }
+        Ripe::AESContext context(key);
+        std::string packetClientId;
+        std::string result;
+        for (std::size_t pos = 0; pos < size;) {
+            const std::size_t packetSize = Ripe::binaryPacketSize(in + pos, size - pos);
+            if (packetSize == 0 || packetSize > size - pos) {
+                throw std::invalid_argument("Incomplete binary packet at byte " + std::to_string(pos));
+            }
+            result += Ripe::decryptBinaryData(in + pos, packetSize, context, packetClientId);
+            pos += packetSize;
+        }
+        writeOutput(outputFile, result);
     CATCH
 }
 
-void decodeHex(std::string& data)
+void streamAES(bool encrypt, const std::string& inputFile, const std::string& outputFile,
+               const std::string& key, const std::string& iv)
 {
     TRY
-        std::cout << Ripe::hexToString(data);
+        std::ifstream fin;
+        std::istream* in = &std::cin;
+        if (!inputFile.empty()) {
+            fin.open(inputFile.c_str(), std::ios::in | std::ios::binary);
+            if (!fin.is_open()) {
+                throw std::runtime_error("Unable to open input file [" + inputFile + "]");
+            }
+            in = &fin;
+        }
+        std::ofstream fout;
+        std::ostream* out = &openOutput(outputFile, fout);
+        const std::string rawKey = Ripe::hexToString(key);
+        const RipeByte* keyBytes = reinterpret_cast<const RipeByte*>(rawKey.data());
+        Ripe::AESIV rawIv;
+        if (encrypt) {
+            if (!Ripe::parseIV(iv.empty() ? Ripe::generateNewKey(Ripe::AES_BLOCK_SIZE) : iv, rawIv)) {
+                throw std::invalid_argument("Invalid IV");
+            }
+            // When cipher is written to console, IV goes to stderr so it does not mix with the data
+            std::ostream& ivOut = outputFile.empty() ? std::cerr : std::cout;
+            ivOut << "IV: " << Ripe::ivToString(rawIv) << std::endl;
+            Ripe::encryptAES(*in, *out, keyBytes, rawKey.size(), rawIv.data());
+        } else {
+            if (!Ripe::parseIV(iv, rawIv)) {
+                throw std::invalid_argument("Please provide valid IV (--iv) for stream decryption");
+            }
+            Ripe::decryptAES(*in, *out, keyBytes, rawKey.size(), rawIv.data());
+        }
+    CATCH
+}
+
+void chunkedAES(bool encrypt, const std::string& inputFile, const std::string& outputFile,
+                const std::string& key, const std::string& aesMode, unsigned int threads)
+{
+    TRY
+        const std::string rawKey = Ripe::hexToString(key);
+        const RipeByte* keyBytes = reinterpret_cast<const RipeByte*>(rawKey.data());
+        const Ripe::AESMode mode = aesMode == "cbc" ? Ripe::AES_CBC : Ripe::AES_GCM;
+        if (!inputFile.empty() && !outputFile.empty()) {
+            // Files are processed a few segments at a time
+            if (encrypt) {
+                Ripe::encryptAESFile(inputFile, outputFile, keyBytes, rawKey.size(), mode, threads);
+            } else {
+                Ripe::decryptAESFile(inputFile, outputFile, keyBytes, rawKey.size(), threads);
+            }
+            return;
+        }
+        std::string data;
+        if (inputFile.empty()) {
+            data = readStream(std::cin);
+        } else {
+            InputFile input(inputFile);
+            data.assign(input.data(), input.size());
+        }
+        const std::string result = encrypt ? Ripe::encryptAESChunked(data, keyBytes, rawKey.size(), mode, threads)
+                                           : Ripe::decryptAESChunked(data, keyBytes, rawKey.size(), threads);
+        writeOutput(outputFile, result);
+    CATCH
+}
+
+void generateAESKey(int length)
+{
+    if (length == 0 || length == 2048) {
+        std::cout << "ERROR: Please provide valid key length" << std::endl;
+        return;
+    }
+    TRY
+        std::cout << Ripe::generateNewKey(length / 8);
+    CATCH
+}
+
+// Encodes (base64 or hex) a block at a time so encoded data is never held in full
+void encode(const RipeByte* data, std::size_t n, bool isBase64, const std::string& outputFile)
+{
+    TRY
+        // Multiple of 3 so base64 of blocks is same as base64 of whole data
+        const std::size_t blockSize = 3 * Ripe::STREAM_CHUNK_SIZE;
+        std::vector<RipeByte> buffer(isBase64 ? Ripe::expectedBase64Length(blockSize) : 2 * blockSize);
+        std::ofstream file;
+        std::ostream& out = openOutput(outputFile, file);
+        for (std::size_t offset = 0; offset < n; offset += blockSize) {
+            const std::size_t length = std::min(blockSize, n - offset);
+            const std::size_t written = isBase64 ? Ripe::base64Encode(data + offset, length, buffer.data(), buffer.size())
+                                                 : Ripe::stringToHex(data + offset, length, buffer.data(), buffer.size());
+            out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(written));
+        }
+        out.flush();
+    CATCH
+}
+
+void decode(const RipeByte* data, std::size_t n, bool isBase64, const std::string& outputFile)
+{
+    TRY
+        std::vector<RipeByte> buffer(isBase64 ? Ripe::maxBase64DecodedLength(n) : n / 2);
+        const std::size_t written = isBase64 ? Ripe::base64Decode(data, n, buffer.data(), buffer.size())
+                                             : Ripe::hexToString(data, n, buffer.data(), buffer.size());
+        writeOutput(outputFile, reinterpret_cast<const char*>(buffer.data()), written);
     CATCH
 }
 
@@ -155,13 +470,7 @@ void compress(std::string& data, bool isBase64, bool isHex,
         if (isBase64) {
             o = Ripe::base64Encode(o);
         }
-        if (outputFile.empty()) {
-            std::cout << o;
-        } else {
-            std::ofstream out(outputFile.c_str());
-            out << o;
-            out.close();
-        }
+        writeOutput(outputFile, o);
     CATCH
 }
 
@@ -175,13 +484,32 @@ void decompress(std::string& data, bool isBase64, bool isHex,
         if (isHex) {
             data = Ripe::hexToString(data);
         }
-        std::string o = Ripe::decompressString(data);
-        if (outputFile.empty()) {
-            std::cout << o;
+        writeOutput(outputFile, Ripe::decompressString(data));
+    CATCH
+}
+
+void compressAndEncrypt(const std::string& data, const std::string& key, const std::string& iv,
+                        const std::string& clientId, const std::string& outputFile)
+{
+    TRY
+        writeOutput(outputFile, Ripe::prepareCompressedData(data, key, clientId, iv));
+    CATCH
+}
+
+void decryptAndDecompress(const std::string& data, const std::string& key, const std::string& outputFile)
+{
+    TRY
+        writeOutput(outputFile, Ripe::decryptCompressedData(data, key));
+    CATCH
+}
+
+void gzipFile(bool compress, const std::string& inputFile, const std::string& outputFile, unsigned int threads)
+{
+    TRY
+        if (compress) {
+            Ripe::compressFile(outputFile, inputFile, threads);
         } else {
-            std::ofstream out(outputFile.c_str());
-            out << o;
-            out.close();
+            Ripe::decompressFile(inputFile, outputFile);
         }
     CATCH
 }
@@ -200,6 +528,22 @@ void sha512(std::string& data)
     CATCH
 }
 
+void blake2b(const std::string& data)
+{
+    TRY
+    Ripe::Hasher hasher(Ripe::HASH_BLAKE2B);
+    hasher.update(data);
+    std::cout << hasher.final();
+    CATCH
+}
+
+void hashFile(const std::string& inputFile, Ripe::HashAlgorithm algorithm)
+{
+    TRY
+    std::cout << Ripe::hashFile(inputFile, algorithm);
+    CATCH
+}
+
 void encryptRSA(std::string& data, const std::string& key,
                 const std::string& outputFile, bool isRaw)
 {
@@ -216,19 +560,247 @@ void decryptRSA(std::string& data, const std::string& key,
     CATCH
 }
 
-void signRSA(std::string& data, const std::string& key,
-             const std::string& keySecret)
+void encryptRSAEnvelope(const std::string& data, const std::string& key,
+                        const std::string& outputFile, bool isRaw)
 {
     TRY
-        std::cout << Ripe::signRSA(data, key, keySecret);
+        std::string encrypted = Ripe::encryptRSAEnvelope(data, key);
+        if (!isRaw) {
+            encrypted = Ripe::base64Encode(encrypted);
+        }
+        writeOutput(outputFile, encrypted);
     CATCH
 }
 
-void verifyRSA(std::string& data, const std::string& signature,
-               const std::string& key)
+void decryptRSAEnvelope(std::string& data, const std::string& key,
+                        bool isBase64, const std::string& secret, const std::string& outputFile)
 {
     TRY
-        std::cout << (Ripe::verifyRSA(data, signature, key) ? "OK" : "FAIL");
+        if (isBase64) {
+            data = Ripe::base64Decode(data);
+        }
+        writeOutput(outputFile, Ripe::decryptRSAEnvelope(data, key, secret));
+    CATCH
+}
+
+void sign(std::string& data, const std::string& key,
+          const std::string& keySecret, Ripe::SignatureScheme scheme)
+{
+    TRY
+        std::cout << Ripe::sign(data, key, scheme, keySecret);
+    CATCH
+}
+
+void verify(std::string& data, const std::string& signature,
+            const std::string& key, Ripe::SignatureScheme scheme)
+{
+    TRY
+        std::cout << (Ripe::verify(data, signature, key, scheme) ? "OK" : "FAIL");
+    CATCH
+}
+
+// Splits newline-delimited records, empty lines are ignored
+std::vector<std::string> splitRecords(const std::string& data)
+{
+    std::vector<std::string> records;
+    std::size_t start = 0;
+    while (start < data.size()) {
+        std::size_t end = data.find('\n', start);
+        if (end == std::string::npos) {
+            end = data.size();
+        }
+        std::size_t length = end - start;
+        if (length > 0 && data[end - 1] == '\r') {
+            --length;
+        }
+        if (length > 0) {
+            records.push_back(data.substr(start, length));
+        }
+        start = end + 1;
+    }
+    return records;
+}
+
+void signBatch(const std::string& data, const std::string& key,
+               const std::string& keySecret, Ripe::SignatureScheme scheme, unsigned int threads)
+{
+    TRY
+        const std::vector<std::string> messages = splitRecords(data);
+        const std::vector<std::string> signatures = Ripe::signBatch(messages, key, scheme, keySecret, threads);
+        for (std::size_t i = 0; i < messages.size(); ++i) {
+            std::cout << signatures[i] << Ripe::DATA_DELIMITER << messages[i] << "\n";
+        }
+    CATCH
+}
+
+void verifyBatch(const std::string& data, const std::string& key, Ripe::SignatureScheme scheme, unsigned int threads)
+{
+    TRY
+        // Each record is <signature hex>:<data>
+        const std::vector<std::string> records = splitRecords(data);
+        std::vector<std::string> messages(records.size());
+        std::vector<std::string> signatures(records.size());
+        for (std::size_t i = 0; i < records.size(); ++i) {
+            const std::size_t pos = records[i].find(Ripe::DATA_DELIMITER);
+            if (pos != std::string::npos) {
+                signatures[i] = records[i].substr(0, pos);
+                messages[i] = records[i].substr(pos + 1);
+            }
+        }
+        const std::vector<bool> results = Ripe::verifyBatch(messages, signatures, key, scheme, threads);
+        for (std::vector<bool>::const_iterator it = results.begin(); it != results.end(); ++it) {
+            std::cout << (*it ? "OK" : "FAIL") << "\n";
+        }
+    CATCH
+}
+
+typedef std::function<std::string(const std::string&)> RecordFunction;
+
+// Applies function to every record of input and writes results in the same order, each followed by delimiter.
+// Records are read (and written) a block at a time so memory use does not depend on input size. Each thread
+// gets its own function from createFunction so per-thread state (AES context, hasher) is not shared
+void processRecords(std::istream& in, std::ostream& out, char delimiter, unsigned int threads,
+                    const std::function<RecordFunction()>& createFunction)
+{
+    const std::size_t BLOCK_RECORDS = 4096;
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    std::vector<RecordFunction> functions;
+    for (unsigned int i = 0; i < threads; ++i) {
+        functions.push_back(createFunction());
+    }
+    std::vector<std::string> records(BLOCK_RECORDS);
+    std::vector<std::string> results(BLOCK_RECORDS);
+    std::string output;
+    for (;;) {
+        std::size_t count = 0;
+        while (count < BLOCK_RECORDS && std::getline(in, records[count], delimiter)) {
+            std::string& record = records[count];
+            if (delimiter == '\n' && !record.empty() && record[record.size() - 1] == '\r') {
+                record.erase(record.size() - 1);
+            }
+            ++count;
+        }
+        if (count == 0) {
+            break;
+        }
+        // Failure of one record does not stop the rest, error is written in its place
+        auto run = [&](unsigned int worker, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                try {
+                    results[i] = functions[worker](records[i]);
+                } catch (const std::exception& e) {
+                    results[i] = std::string("ERROR: ") + e.what();
+                }
+            }
+        };
+        const unsigned int workers = static_cast<unsigned int>(std::min<std::size_t>(threads, count));
+        const std::size_t perWorker = (count + workers - 1) / workers;
+        std::vector<std::thread> pool;
+        for (unsigned int w = 1; w < workers; ++w) {
+            pool.emplace_back(run, w, std::min(count, w * perWorker), std::min(count, (w + 1) * perWorker));
+        }
+        run(0, 0, std::min(count, perWorker));
+        for (std::vector<std::thread>::iterator it = pool.begin(); it != pool.end(); ++it) {
+            it->join();
+        }
+        output.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            output.append(results[i]);
+            output.push_back(delimiter);
+        }
+        out.write(output.data(), output.size());
+        if (count < BLOCK_RECORDS) {
+            break;
+        }
+    }
+    out.flush();
+}
+
+void eachLine(bool encrypt, const std::string& inputFile, const std::string& outputFile,
+              const std::string& key, const std::string& aesMode, const std::string& clientId,
+              bool isBase64, bool isHex, bool isHash, Ripe::HashAlgorithm algorithm,
+              char delimiter, unsigned int threads)
+{
+    TRY
+        std::function<RecordFunction()> createFunction;
+        if (isBase64 && key.empty()) {
+            createFunction = [encrypt]() -> RecordFunction {
+                if (encrypt) {
+                    return [](const std::string& record) { return Ripe::base64Encode(record); };
+                }
+                return [](const std::string& record) { return Ripe::base64Decode(record); };
+            };
+        } else if (isHex && key.empty()) {
+            createFunction = [encrypt]() -> RecordFunction {
+                if (encrypt) {
+                    return [](const std::string& record) { return Ripe::stringToHex(record); };
+                }
+                return [](const std::string& record) { return Ripe::hexToString(record); };
+            };
+        } else if (encrypt && isHash) {
+            createFunction = [algorithm]() -> RecordFunction {
+                std::shared_ptr<Ripe::Hasher> hasher = std::make_shared<Ripe::Hasher>(algorithm);
+                return [hasher](const std::string& record) {
+                    hasher->update(record);
+                    return hasher->final();
+                };
+            };
+        } else if (!key.empty() && encrypt) {
+            const bool gcm = aesMode == "gcm";
+            createFunction = [&key, &clientId, gcm]() -> RecordFunction {
+                std::shared_ptr<Ripe::AESContext> context = std::make_shared<Ripe::AESContext>(key);
+                return [context, &clientId, gcm](const std::string& record) {
+                    std::string result;
+                    if (gcm) {
+                        Ripe::prepareAuthenticatedData(record, *context, result, clientId);
+                    } else {
+                        Ripe::prepareData(record, *context, result, clientId);
+                    }
+                    // Packet delimiter would break the line framing, it is added back for decryption
+                    if (result.size() >= Ripe::PACKET_DELIMITER_SIZE
+                            && result.compare(result.size() - Ripe::PACKET_DELIMITER_SIZE, Ripe::PACKET_DELIMITER_SIZE, Ripe::PACKET_DELIMITER) == 0) {
+                        result.erase(result.size() - Ripe::PACKET_DELIMITER_SIZE);
+                    }
+                    return result;
+                };
+            };
+        } else if (!key.empty()) {
+            createFunction = [&key]() -> RecordFunction {
+                std::shared_ptr<Ripe::AESContext> context = std::make_shared<Ripe::AESContext>(key);
+                std::shared_ptr<Ripe::PacketDecoder> decoder = std::make_shared<Ripe::PacketDecoder>();
+                return [context, decoder](const std::string& record) {
+                    // IV size tells whether it is CBC or GCM packet
+                    decoder->clear();
+                    decoder->feed(record);
+                    decoder->feed(Ripe::PACKET_DELIMITER);
+                    Ripe::PacketDecoder::Packet packet;
+                    if (!decoder->next(packet)) {
+                        throw std::invalid_argument("Invalid packet");
+                    }
+                    std::string result;
+                    decoder->decrypt(packet, *context, result);
+                    return result;
+                };
+            };
+        } else {
+            throw std::invalid_argument("Line mode supports --base64, --hex, hashing (-e) and AES (--key)");
+        }
+
+        std::ifstream fin;
+        std::istream* in = &std::cin;
+        if (!inputFile.empty()) {
+            fin.open(inputFile.c_str(), std::ios::in | std::ios::binary);
+            if (!fin.is_open()) {
+                throw std::runtime_error("Unable to open input file [" + inputFile + "]");
+            }
+            in = &fin;
+        } else {
+            std::ios::sync_with_stdio(false);
+        }
+        std::ofstream fout;
+        processRecords(*in, openOutput(outputFile, fout), delimiter, threads, createFunction);
     CATCH
 }
 
@@ -251,6 +823,57 @@ void generateRSAKeyPair(std::size_t length, const std::string& secret)
     CATCH
 }
 
+void writeEd25519KeyPair(const std::string& publicFile, const std::string& privateFile)
+{
+    TRY
+        if (Ripe::writeEd25519KeyPair(publicFile, privateFile)) {
+            std::cout << "Successfully saved!" << std::endl;
+        }
+    CATCH
+}
+
+void generateEd25519KeyPair()
+{
+    TRY
+        // Same format as RSA, <private key base64>:<public key base64>
+        Ripe::KeyPair pair = Ripe::generateEd25519KeyPair();
+        std::cout << Ripe::base64Encode(pair.privateKey) << ":" << Ripe::base64Encode(pair.publicKey);
+    CATCH
+}
+
+bool parseSignatureScheme(const std::string& name, Ripe::SignatureScheme& scheme)
+{
+    if (name == "rsa") {
+        scheme = Ripe::SIGNATURE_RSA_PKCS1_SHA1;
+    } else if (name == "rsa-pss") {
+        scheme = Ripe::SIGNATURE_RSA_PSS_SHA256;
+    } else if (name == "ed25519") {
+        scheme = Ripe::SIGNATURE_ED25519;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Prints statistics to stderr when it goes out of scope
+class StatsDump {
+public:
+    explicit StatsDump(bool enabled) :
+        m_enabled(enabled)
+    {
+    }
+
+    ~StatsDump()
+    {
+        if (m_enabled) {
+            std::cerr << statsToJson() << std::endl;
+        }
+    }
+
+private:
+    bool m_enabled;
+};
+
 bool rtrimPred(char c) {
     return !std::isspace(c);
 }
@@ -263,7 +886,7 @@ int main(int argc, char* argv[])
     }
 
     if (strcmp(argv[1], "--version") == 0) {
-        displayVersion();
+        displayVersion(argc > 2 && strcmp(argv[2], "--verbose") == 0);
         return 0;
     }
 
@@ -280,16 +903,35 @@ int main(int argc, char* argv[])
     std::string secret;
     std::string signatureHex;
     bool isAES = false;
+    bool isEd25519 = false;
     bool isZlib = false;
+    bool isGzip = false;
     bool isBase64 = false;
     bool isHex = false;
     bool clean = false;
     bool isRSA = false;
     bool isRaw = false;
+    bool isEnvelope = false;
     bool isSha256 = false;
     bool isSha512 = false;
+    bool isBlake2b = false;
     std::string outputFile;
-    bool fileArgSpecified = false;
+    std::string inputFile;
+    bool isStream = false;
+    bool isChunked = false;
+    bool isBatch = false;
+    bool isEachLine = false;
+    bool isBinary = false;
+    bool isNullDelimited = false;
+    unsigned int threads = 0;
+    std::string aesMode = "cbc";
+    bool aesModeSet = false;
+    std::string signatureScheme = "rsa";
+    bool isServe = false;
+    bool isStats = false;
+    std::string socketPath;
+    std::string privateKeyPEM;
+    std::string publicKeyPEM;
 
     for (int i = 0; i < argc; i++) {
         std::string arg(argv[i]);
@@ -312,12 +954,18 @@ int main(int argc, char* argv[])
             isRSA = true;
         } else if (arg == "--zlib") {
             isZlib = true;
+        } else if (arg == "--gzip") {
+            isGzip = true;
         } else if (arg == "--sha256" || arg == "--hash") {
             isSha256 = true;
         } else if (arg == "--sha512") {
             isSha512 = true;
+        } else if (arg == "--blake2b") {
+            isBlake2b = true;
         } else if (arg == "--signature" && hasNext) {
             signatureHex = argv[++i];
+        } else if (arg == "--envelope") {
+            isEnvelope = true;
         } else if (arg == "--raw") {
             isRaw = true;
         } else if (arg == "--key" && hasNext) {
@@ -332,6 +980,10 @@ int main(int argc, char* argv[])
                     --i;
                 }
             }
+        } else if (arg == "--ed25519") {
+            isEd25519 = true;
+        } else if (arg == "--scheme" && hasNext) {
+            signatureScheme = argv[++i];
         } else if (arg == "--length" && hasNext) {
             keyLength = atoi(argv[++i]);
         } else if (arg == "--secret" && hasNext) {
@@ -343,12 +995,30 @@ int main(int argc, char* argv[])
         } else if (arg == "--out-private" && hasNext) {
             privateKeyFile = argv[++i];
         } else if (arg == "--in-key" && hasNext) {
-            std::fstream fs;
             // Do not increment i here as we are only changing 'data'
-            fs.open (argv[i + 1], std::fstream::binary | std::fstream::in);
-            key = std::string((std::istreambuf_iterator<char>(fs)),
-                            (std::istreambuf_iterator<char>()));
-            fs.close();
+            try {
+                InputFile keyFile(argv[i + 1]);
+                key.assign(keyFile.data(), keyFile.size());
+            } catch (const std::exception& e) {
+                std::cerr << "ERROR: " << e.what() << std::endl;
+                return 1;
+            }
+        } else if (arg == "--aes-mode" && hasNext) {
+            aesMode = argv[++i];
+            aesModeSet = true;
+        } else if (arg == "--batch") {
+            isBatch = true;
+        } else if (arg == "--each-line") {
+            isEachLine = true;
+        } else if (arg == "--null") {
+            isNullDelimited = true;
+        } else if (arg == "--binary") {
+            isBinary = true;
+        } else if (arg == "--stream") {
+            isStream = true;
+        } else if (arg == "--threads" && hasNext) {
+            isChunked = true;
+            threads = static_cast<unsigned int>(atoi(argv[++i]));
         } else if (arg == "--out" && hasNext) {
             outputFile = argv[++i];
         } else if (arg == "--iv" && hasNext) {
@@ -356,24 +1026,129 @@ int main(int argc, char* argv[])
         } else if (arg == "--client-id" && hasNext) {
             clientId = argv[++i];
         } else if (arg == "--in" && hasNext) {
-            fileArgSpecified = true;
-            std::fstream fs;
-            // Do not increment i here as we are only changing 'data'
-            fs.open (argv[i + 1], std::fstream::binary | std::fstream::in);
-            data = std::string((std::istreambuf_iterator<char>(fs) ),
-                            (std::istreambuf_iterator<char>()));
-            fs.close();
+            inputFile = argv[++i];
+        } else if (arg == "--serve") {
+            isServe = true;
+        } else if (arg == "--stats") {
+            isStats = true;
+        } else if (arg == "--socket" && hasNext) {
+            socketPath = argv[++i];
+        } else if ((arg == "--in-private" || arg == "--in-public") && hasNext) {
+            try {
+                InputFile keyFile(argv[++i]);
+                (arg == "--in-private" ? privateKeyPEM : publicKeyPEM).assign(keyFile.data(), keyFile.size());
+            } catch (const std::exception& e) {
+                std::cerr << "ERROR: " << e.what() << std::endl;
+                return 1;
+            }
         }
     }
 
-    if ((type == 1 || type == 2 || type == 4 || type == 5) && !fileArgSpecified) {
-        std::stringstream ss;
-        for (std::string line; std::getline(std::cin, line);) {
-            ss << line << std::endl;
+    if (aesMode != "cbc" && aesMode != "gcm") {
+        std::cerr << "ERROR: Invalid AES mode [" << aesMode << "], valid modes are cbc and gcm" << std::endl;
+        return 1;
+    }
+
+    Ripe::SignatureScheme scheme = Ripe::SIGNATURE_RSA_PKCS1_SHA1;
+    if (!parseSignatureScheme(signatureScheme, scheme)) {
+        std::cerr << "ERROR: Invalid signature scheme [" << signatureScheme << "], valid schemes are rsa, rsa-pss and ed25519" << std::endl;
+        return 1;
+    }
+
+    // Statistics are printed on every return from here on
+    StatsDump statsDump(isStats);
+    if (isStats && type == -1 && !isServe) {
+        return 0;
+    }
+
+    if (isServe) {
+        ServerOptions options;
+        options.key = key;
+        options.aesMode = aesMode;
+        options.clientId = clientId;
+        options.privateKeyPEM = privateKeyPEM;
+        options.publicKeyPEM = publicKeyPEM;
+        options.secret = secret;
+        options.scheme = scheme;
+        options.hashAlgorithm = isSha512 ? Ripe::HASH_SHA512 : isBlake2b ? Ripe::HASH_BLAKE2B : Ripe::HASH_SHA256;
+        options.threads = threads;
+        options.socketPath = socketPath;
+        return runServer(options);
+    }
+
+    if ((type == 1 || type == 2) && isGzip) {
+        if (inputFile.empty() || outputFile.empty()) {
+            std::cerr << "ERROR: Please provide input and output files [in] and [out] for gzip" << std::endl;
+            return 1;
+        }
+        gzipFile(type == 2, inputFile, outputFile, threads);
+        return 0;
+    }
+
+    if ((type == 1 || type == 2) && isBinary) {
+        if (key.empty() || isRSA || isZlib || isBase64 || isHex || isEachLine || isBatch || isStream || isChunked) {
+            std::cerr << "ERROR: --binary only works with AES encryption / decryption with --key" << std::endl;
+            return 1;
         }
-        data = ss.str();
+        binaryData(type == 2, inputFile, outputFile, key, iv, clientId, aesMode == "gcm");
+        return 0;
+    }
+
+    if ((type == 1 || type == 2) && (isEachLine || isBatch) && !isRSA && !isZlib) {
+        // Every record is processed on its own, threads are only used when asked for
+        eachLine(type == 2, inputFile, outputFile, key, aesMode, clientId, isBase64, isHex,
+                 isSha256 || isSha512 || isBlake2b, isSha512 ? Ripe::HASH_SHA512 : isBlake2b ? Ripe::HASH_BLAKE2B : Ripe::HASH_SHA256,
+                 isNullDelimited ? '\0' : '\n', isChunked ? threads : 1);
+        return 0;
+    }
+
+    if ((type == 1 || type == 2) && isStream && !isRSA && !isZlib && !key.empty()) {
+        // Stream mode does not load input in to memory
+        streamAES(type == 2, inputFile, outputFile, key, iv);
+        return 0;
+    }
+
+    if ((type == 1 || type == 2) && isChunked && !isRSA && !isZlib && !key.empty()) {
+        // Chunked container always uses GCM unless cbc is explicitly requested
+        chunkedAES(type == 2, inputFile, outputFile, key, aesModeSet ? aesMode : "gcm", threads);
+        return 0;
+    }
+
+    if (type == 2 && (isSha256 || isSha512 || isBlake2b) && !inputFile.empty() && !isBase64 && !isHex && !isZlib) {
+        // Files are hashed without loading them in to memory
+        hashFile(inputFile, isSha256 ? Ripe::HASH_SHA256 : isSha512 ? Ripe::HASH_SHA512 : Ripe::HASH_BLAKE2B);
+        return 0;
+    }
+
+    if (!inputFile.empty()) {
+        std::unique_ptr<InputFile> input;
+        try {
+            input.reset(new InputFile(inputFile));
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+        // Following operations work on mapped file directly
+        if ((type == 1 || type == 2) && (isBase64 || isHex) && key.empty() && iv.empty() && !isZlib && !clean) {
+            if (type == 2) {
+                encode(input->bytes(), input->size(), isBase64, outputFile);
+            } else {
+                decode(input->bytes(), input->size(), isBase64, outputFile);
+            }
+            return 0;
+        }
+        if (type == 2 && !key.empty() && !outputFile.empty() && aesMode == "cbc" && !isRSA && !isZlib
+                && !isBase64 && !isHex && !isSha256 && !isSha512 && !isBlake2b) {
+            encryptAESToFile(*input, key, iv, outputFile);
+            return 0;
+        }
+        data.assign(input->data(), input->size());
+    } else if (type == 1 || type == 2 || type == 4 || type == 5) {
+        data = readStream(std::cin);
         // Remove last 'new line'
-        data.erase(data.size() - 1);
+        if (!data.empty() && data[data.size() - 1] == '\n') {
+            data.erase(data.size() - 1);
+        }
     }
 
     if ((isBase64 || isHex) && clean) {
@@ -383,32 +1158,46 @@ int main(int argc, char* argv[])
     if (type == 1) { // Decrypt / Decode
         if (isBase64 && key.empty() && iv.empty() && !isZlib) {
             // base64 decode
-            decodeBase64(data);
+            decode(reinterpret_cast<const RipeByte*>(data.data()), data.size(), true, outputFile);
         } else if (isHex && key.empty() && iv.empty() && !isZlib) {
             // hex to ascii
-            decodeHex(data);
+            decode(reinterpret_cast<const RipeByte*>(data.data()), data.size(), false, outputFile);
+        } else if (isZlib && !key.empty()) {
+            decryptAndDecompress(data, key, outputFile);
         } else if (isZlib) {
             decompress(data, isBase64, isHex, outputFile);
+        } else if (isRSA && isEnvelope) {
+            decryptRSAEnvelope(data, key, isBase64, secret, outputFile);
         } else if (isRSA) {
             // RSA decrypt (base64-flexible)
             decryptRSA(data, key, isBase64, isHex, secret);
+        } else if (aesMode == "gcm") {
+            decryptAESGCM(data, key, iv, clientId, isBase64, outputFile);
         } else {
             // AES decrypt (base64-flexible)
             decryptAES(data, key, iv, isBase64, isHex);
         }
     } else if (type == 2) { // Encrypt / Encode
         if (isBase64 && key.empty() && iv.empty() && !isZlib) {
-            encodeBase64(data);
+            encode(reinterpret_cast<const RipeByte*>(data.data()), data.size(), true, outputFile);
         } else if (isHex && key.empty() && iv.empty() && !isZlib) {
-            encodeHex(data);
+            encode(reinterpret_cast<const RipeByte*>(data.data()), data.size(), false, outputFile);
+        } else if (isZlib && !key.empty()) {
+            compressAndEncrypt(data, key, iv, clientId, outputFile);
         } else if (isZlib) {
             compress(data, isBase64, isHex, outputFile);
         } else if (isSha256) {
             sha256(data);
         } else if (isSha512) {
             sha512(data);
+        } else if (isBlake2b) {
+            blake2b(data);
+        } else if (isRSA && isEnvelope) {
+            encryptRSAEnvelope(data, key, outputFile, isRaw);
         } else if (isRSA) {
             encryptRSA(data, key, outputFile, isRaw);
+        } else if (aesMode == "gcm") {
+            encryptAESGCM(data, key, iv, clientId, outputFile);
         } else {
             encryptAES(data, key, iv, clientId, outputFile);
         }
@@ -429,24 +1218,36 @@ int main(int argc, char* argv[])
                     writeRSAKeyPair(publicKeyFile, privateKeyFile, keyLength, secret);
                 }
             }
+        } else if (isEd25519) {
+            if (publicKeyFile.empty() && privateKeyFile.empty()) {
+                generateEd25519KeyPair();
+            } else if (publicKeyFile.empty() || privateKeyFile.empty()) {
+                std::cerr << "ERROR: Please provide both private and public key files [out-public] and [out-private]" << std::endl;
+            } else {
+                writeEd25519KeyPair(publicKeyFile, privateKeyFile);
+            }
         } else if (isAES) {
             generateAESKey(keyLength);
         } else {
-            std::cerr << "ERROR: Please provide method (you probably forgot '--rsa' or '--aes')" << std::endl;
+            std::cerr << "ERROR: Please provide method (you probably forgot '--rsa', '--ed25519' or '--aes')" << std::endl;
         }
-    } else if (type == 4) { // Sign RSA
+    } else if (type == 4) { // Sign
         if (key.empty()) {
             std::cerr << "ERROR: Please provide private key to sign the data with" << std::endl;
+        } else if (isBatch) {
+            signBatch(data, key, secret, scheme, threads);
         } else {
-            signRSA(data, key, secret);
+            sign(data, key, secret, scheme);
         }
-    } else if (type == 5) { // Verify RSA
+    } else if (type == 5) { // Verify
         if (key.empty()) {
             std::cerr << "ERROR: Please provide public key to verify the data with" << std::endl;
-        } if (signatureHex.empty()) {
+        } else if (isBatch) {
+            verifyBatch(data, key, scheme, threads);
+        } else if (signatureHex.empty()) {
             std::cerr << "ERROR: Please provide signature (in hex format)" << std::endl;
         } else {
-            verifyRSA(data, signatureHex, key);
+            verify(data, signatureHex, key, scheme);
         }
     } else {
         displayUsage();
@@ -0,0 +1,662 @@
+//
+//  Ripe
+//
+//  Copyright 2017-present Amrayn Web Services
+//
+//  https://muflihun.com
+//  https://amrayn.com
+//  https://github.com/amrayn/ripe
+//
+//  Author: @abumusamq
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "server.h"
+
+// Requests bigger than this are rejected before their data is read
+const std::size_t SERVER_MAX_REQUEST_SIZE = 64 * 1024 * 1024;
+
+// Longer header lines are rejected so a client cannot grow memory by never sending new line
+const std::size_t SERVER_MAX_HEADER_SIZE = 1024;
+
+// Data of requests that are read but not responded yet (of all connections)
+const std::size_t SERVER_MAX_IN_FLIGHT_SIZE = 4 * SERVER_MAX_REQUEST_SIZE;
+
+///
+/// \brief Source of requests and sink of responses. Responses are written by
+/// worker threads so every response is written as a whole under lock
+///
+class ServerConnection {
+public:
+    virtual ~ServerConnection()
+    {
+    }
+
+    ///
+    /// \brief Reads next line (without new line), false at end of input
+    /// \throws std::length_error if line is longer than SERVER_MAX_HEADER_SIZE
+    ///
+    virtual bool readLine(std::string& line) = 0;
+
+    ///
+    /// \brief Reads exactly n bytes, false if input ends first
+    ///
+    virtual bool read(std::string& data, std::size_t n) = 0;
+
+    void respond(const std::string& id, bool ok, const std::string& body)
+    {
+        const std::string header = id + (ok ? " ok " : " error ") + std::to_string(body.size()) + "\n";
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        write(header.data(), header.size());
+        write(body.data(), body.size());
+        flush();
+    }
+
+protected:
+    virtual void write(const char* data, std::size_t n) = 0;
+    virtual void flush() = 0;
+
+private:
+    std::mutex m_writeMutex;
+};
+
+class StreamConnection : public ServerConnection {
+public:
+    StreamConnection(std::istream& in, std::ostream& out) :
+        m_in(in),
+        m_out(out)
+    {
+    }
+
+    bool readLine(std::string& line) override
+    {
+        line.clear();
+        std::streambuf* buffer = m_in.rdbuf();
+        for (;;) {
+            const int c = buffer->sbumpc();
+            if (c == std::char_traits<char>::eof()) {
+                m_in.setstate(std::ios::eofbit);
+                return !line.empty();
+            }
+            if (c == '\n') {
+                break;
+            }
+            if (line.size() >= SERVER_MAX_HEADER_SIZE) {
+                throw std::length_error("Request header is too long");
+            }
+            line.push_back(static_cast<char>(c));
+        }
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+        return true;
+    }
+
+    bool read(std::string& data, std::size_t n) override
+    {
+        data.resize(n);
+        m_in.read(&data[0], static_cast<std::streamsize>(n));
+        return static_cast<std::size_t>(m_in.gcount()) == n;
+    }
+
+protected:
+    void write(const char* data, std::size_t n) override
+    {
+        m_out.write(data, static_cast<std::streamsize>(n));
+    }
+
+    void flush() override
+    {
+        m_out.flush();
+    }
+
+private:
+    std::istream& m_in;
+    std::ostream& m_out;
+};
+
+#ifndef _WIN32
+class SocketConnection : public ServerConnection {
+public:
+    explicit SocketConnection(int fd) :
+        m_fd(fd),
+        m_buffer(65536),
+        m_start(0),
+        m_end(0)
+    {
+    }
+
+    ~SocketConnection()
+    {
+        close(m_fd);
+    }
+
+    bool readLine(std::string& line) override
+    {
+        line.clear();
+        for (;;) {
+            if (m_start == m_end && !fill()) {
+                return !line.empty();
+            }
+            const char* begin = m_buffer.data() + m_start;
+            const char* newLine = static_cast<const char*>(memchr(begin, '\n', m_end - m_start));
+            if (newLine != nullptr) {
+                if (line.size() + static_cast<std::size_t>(newLine - begin) > SERVER_MAX_HEADER_SIZE) {
+                    throw std::length_error("Request header is too long");
+                }
+                line.append(begin, newLine);
+                m_start += static_cast<std::size_t>(newLine - begin) + 1;
+                if (!line.empty() && line[line.size() - 1] == '\r') {
+                    line.erase(line.size() - 1);
+                }
+                return true;
+            }
+            if (line.size() + (m_end - m_start) > SERVER_MAX_HEADER_SIZE) {
+                throw std::length_error("Request header is too long");
+            }
+            line.append(begin, m_end - m_start);
+            m_start = m_end;
+        }
+    }
+
+    bool read(std::string& data, std::size_t n) override
+    {
+        data.resize(n);
+        std::size_t done = std::min(n, m_end - m_start);
+        std::copy(m_buffer.data() + m_start, m_buffer.data() + m_start + done, &data[0]);
+        m_start += done;
+        // Rest of big payloads is read directly in to data
+        while (done < n) {
+            const ssize_t count = ::read(m_fd, &data[done], n - done);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            done += static_cast<std::size_t>(count);
+        }
+        return true;
+    }
+
+protected:
+    void write(const char* data, std::size_t n) override
+    {
+        while (n > 0) {
+            const ssize_t count = ::write(m_fd, data, n);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                throw std::runtime_error("Unable to write response");
+            }
+            data += count;
+            n -= static_cast<std::size_t>(count);
+        }
+    }
+
+    void flush() override
+    {
+    }
+
+private:
+    int m_fd;
+    std::vector<char> m_buffer;
+    std::size_t m_start;
+    std::size_t m_end;
+
+    bool fill()
+    {
+        for (;;) {
+            const ssize_t count = ::read(m_fd, m_buffer.data(), m_buffer.size());
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            m_start = 0;
+            m_end = static_cast<std::size_t>(count);
+            return true;
+        }
+    }
+};
+#endif
+
+struct ServerRequest {
+    std::shared_ptr<ServerConnection> connection;
+    std::string id;
+    std::string operation;
+    std::string data;
+};
+
+///
+/// \brief Requests waiting for a worker. Before reader reads data of a request it reserves its size, reader
+/// blocks while data of requests in flight (queued or being handled) would exceed the capacity so clients
+/// cannot make server buffer unlimited data. A request is always admitted when nothing else is in flight.
+///
+class RequestQueue {
+public:
+    explicit RequestQueue(std::size_t capacity) :
+        m_capacity(capacity),
+        m_inFlight(0),
+        m_closed(false)
+    {
+    }
+
+    ///
+    /// \brief Waits until size bytes can be in flight, false if queue is closed
+    ///
+    bool reserve(std::size_t size)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [&]() { return m_closed || m_inFlight == 0 || m_inFlight + size <= m_capacity; });
+        if (m_closed) {
+            return false;
+        }
+        m_inFlight += size;
+        return true;
+    }
+
+    ///
+    /// \brief Releases reserved size once request is done (or could not be read)
+    ///
+    void release(std::size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inFlight -= size;
+        m_notFull.notify_all();
+    }
+
+    ///
+    /// \brief Queues request whose size is reserved, false if queue is closed
+    ///
+    bool push(ServerRequest&& request)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) {
+            m_inFlight -= request.data.size();
+            return false;
+        }
+        m_requests.push_back(std::move(request));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    ///
+    /// \brief Takes next request, false once queue is closed and empty
+    ///
+    bool pop(ServerRequest& request)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this]() { return m_closed || !m_requests.empty(); });
+        if (m_requests.empty()) {
+            return false;
+        }
+        request = std::move(m_requests.front());
+        m_requests.pop_front();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::deque<ServerRequest> m_requests;
+    std::size_t m_capacity;
+    std::size_t m_inFlight;
+    bool m_closed;
+};
+
+///
+/// \brief Keys that are parsed once and shared by all the workers
+///
+struct ServerKeys {
+    // Workers sign and verify with their own copies that reuse parsed keys
+    std::unique_ptr<Ripe::Signer> signer;
+    std::unique_ptr<Ripe::Verifier> verifier;
+};
+
+///
+/// \brief State of one worker thread, contexts are not thread-safe so every worker has its own
+///
+class ServerWorker {
+public:
+    ServerWorker(const ServerOptions& options, const ServerKeys& keys) :
+        m_options(options),
+        m_hasher(options.hashAlgorithm)
+    {
+        if (!options.key.empty()) {
+            m_context.reset(new Ripe::AESContext(options.key));
+        }
+        if (keys.signer) {
+            m_signer.reset(new Ripe::Signer(*keys.signer));
+        }
+        if (keys.verifier) {
+            m_verifier.reset(new Ripe::Verifier(*keys.verifier));
+        }
+    }
+
+    std::string handle(const std::string& operation, const std::string& data)
+    {
+        if (operation == "encrypt") {
+            std::string result;
+            if (m_options.aesMode == "gcm") {
+                Ripe::prepareAuthenticatedData(data, aesContext(), result, m_options.clientId);
+            } else {
+                Ripe::prepareData(data, aesContext(), result, m_options.clientId);
+            }
+            return result;
+        }
+        if (operation == "decrypt") {
+            // IV size tells whether it is CBC or GCM packet
+            m_decoder.clear();
+            m_decoder.feed(data);
+            if (data.size() < Ripe::PACKET_DELIMITER_SIZE
+                    || data.compare(data.size() - Ripe::PACKET_DELIMITER_SIZE, Ripe::PACKET_DELIMITER_SIZE, Ripe::PACKET_DELIMITER) != 0) {
+                m_decoder.feed(Ripe::PACKET_DELIMITER);
+            }
+            Ripe::PacketDecoder::Packet packet;
+            if (!m_decoder.next(packet)) {
+                throw std::invalid_argument("Invalid packet");
+            }
+            std::string result;
+            m_decoder.decrypt(packet, aesContext(), result);
+            return result;
+        }
+        if (operation == "sign") {
+            if (!m_signer) {
+                throw std::invalid_argument("Server was started without private key [in-private]");
+            }
+            return m_signer->sign(data);
+        }
+        if (operation == "verify") {
+            const std::size_t pos = data.find(Ripe::DATA_DELIMITER);
+            if (pos == std::string::npos) {
+                throw std::invalid_argument("Invalid verify request, expected [SIGNATURE]:[DATA]");
+            }
+            const std::string signature = data.substr(0, pos);
+            const std::string message = data.substr(pos + 1);
+            if (!m_verifier) {
+                throw std::invalid_argument("Server was started without public key [in-public]");
+            }
+            return m_verifier->verify(message, signature) ? "OK" : "FAIL";
+        }
+        if (operation == "hash") {
+            m_hasher.update(data);
+            return m_hasher.final();
+        }
+        if (operation == "compress") {
+            return m_compressor.compress(data);
+        }
+        if (operation == "decompress") {
+            return m_decompressor.decompress(data);
+        }
+        if (operation == "stats") {
+            return statsToJson();
+        }
+        throw std::invalid_argument("Unknown operation [" + operation + "]");
+    }
+
+private:
+    const ServerOptions& m_options;
+    std::unique_ptr<Ripe::AESContext> m_context;
+    std::unique_ptr<Ripe::Signer> m_signer;
+    std::unique_ptr<Ripe::Verifier> m_verifier;
+    Ripe::PacketDecoder m_decoder;
+    Ripe::ZlibCompressor m_compressor;
+    Ripe::ZlibDecompressor m_decompressor;
+    Ripe::Hasher m_hasher;
+
+    Ripe::AESContext& aesContext()
+    {
+        if (!m_context) {
+            throw std::invalid_argument("Server was started without AES key [key]");
+        }
+        return *m_context;
+    }
+};
+
+// Reads requests of a connection in to queue until connection ends or sends invalid header. Queue is shared
+// with reader so it stays valid even if server stops before connection ends
+void readRequests(const std::shared_ptr<ServerConnection>& connection, const std::shared_ptr<RequestQueue>& queue)
+{
+    std::string line;
+    for (;;) {
+        try {
+            if (!connection->readLine(line)) {
+                return;
+            }
+        } catch (const std::length_error& e) {
+            // Stream cannot be resynchronized after bad header
+            connection->respond("-", false, e.what());
+            return;
+        }
+        if (line.empty()) {
+            continue;
+        }
+        ServerRequest request;
+        std::size_t size = 0;
+        std::istringstream header(line);
+        if (!(header >> request.id >> request.operation >> size) || size > SERVER_MAX_REQUEST_SIZE) {
+            connection->respond(request.id.empty() ? "-" : request.id, false,
+                                "Invalid request header, expected [ID] [OPERATION] [SIZE] (maximum size is "
+                                + std::to_string(SERVER_MAX_REQUEST_SIZE) + ")");
+            return;
+        }
+        if (!queue->reserve(size)) {
+            return;
+        }
+        if (!connection->read(request.data, size)) {
+            queue->release(size);
+            return;
+        }
+        request.connection = connection;
+        if (!queue->push(std::move(request))) {
+            return;
+        }
+    }
+}
+
+#ifndef _WIN32
+int listenOnSocket(const std::string& socketPath)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path is too long [" + socketPath + "]");
+    }
+    address.sun_family = AF_UNIX;
+    std::copy(socketPath.begin(), socketPath.end(), address.sun_path);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to create socket");
+    }
+    // Stale socket of previous run is removed, any other file at the path is left alone
+    struct stat existing;
+    if (lstat(socketPath.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            close(fd);
+            throw std::runtime_error("Unable to listen on socket [" + socketPath + "]: file exists and is not a socket");
+        }
+        unlink(socketPath.c_str());
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        throw std::runtime_error("Unable to listen on socket [" + socketPath + "]: " + strerror(errno));
+    }
+    return fd;
+}
+#endif
+
+std::string statsToJson()
+{
+    std::ostringstream ss;
+    ss << "{\"enabled\":" << (Ripe::isStatsEnabled() ? "true" : "false") << ",\"operations\":[";
+    const std::vector<Ripe::OperationStats> stats = Ripe::stats();
+    bool first = true;
+    for (std::vector<Ripe::OperationStats>::const_iterator it = stats.begin(); it != stats.end(); ++it) {
+        if (it->calls == 0) {
+            continue;
+        }
+        std::size_t buckets = it->histogram.size();
+        while (buckets > 0 && it->histogram[buckets - 1] == 0) {
+            --buckets;
+        }
+        ss << (first ? "" : ",") << "{\"name\":\"" << it->name << "\",\"calls\":" << it->calls
+           << ",\"bytes\":" << it->bytes << ",\"totalNanoseconds\":" << it->totalNanoseconds
+           << ",\"maxNanoseconds\":" << it->maxNanoseconds << ",\"histogram\":[";
+        for (std::size_t i = 0; i < buckets; ++i) {
+            ss << (i == 0 ? "" : ",") << it->histogram[i];
+        }
+        ss << "]}";
+        first = false;
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+// Starts workers and handles requests that readAll() reads in to queue, readAll() returns exit code
+int serve(const ServerOptions& options,
+          const std::function<int(const std::shared_ptr<RequestQueue>& queue, unsigned int threads)>& readAll)
+{
+    ServerKeys keys;
+    unsigned int threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<std::unique_ptr<ServerWorker> > workers;
+    try {
+        // Keys are parsed (and validated) once here, not for every request
+        if (!options.privateKeyPEM.empty()) {
+            keys.signer.reset(new Ripe::Signer(options.privateKeyPEM, options.scheme, options.secret));
+        }
+        if (!options.publicKeyPEM.empty()) {
+            keys.verifier.reset(new Ripe::Verifier(options.publicKeyPEM, options.scheme));
+        }
+        for (unsigned int i = 0; i < threads; ++i) {
+            workers.emplace_back(new ServerWorker(options, keys));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::shared_ptr<RequestQueue> queue = std::make_shared<RequestQueue>(SERVER_MAX_IN_FLIGHT_SIZE);
+    std::vector<std::thread> pool;
+    for (unsigned int i = 0; i < threads; ++i) {
+        pool.emplace_back([&queue](ServerWorker* worker) {
+            ServerRequest request;
+            while (queue->pop(request)) {
+                const std::size_t size = request.data.size();
+                bool ok = true;
+                std::string result;
+                try {
+                    result = worker->handle(request.operation, request.data);
+                } catch (const std::exception& e) {
+                    ok = false;
+                    result = e.what();
+                }
+                try {
+                    request.connection->respond(request.id, ok, result);
+                } catch (const std::exception&) {
+                    // Client has gone away
+                }
+                // Connection is closed once its last request is done
+                request = ServerRequest();
+                queue->release(size);
+            }
+        }, workers[i].get());
+    }
+
+    const int status = readAll(queue, threads);
+    queue->close();
+    for (std::vector<std::thread>::iterator it = pool.begin(); it != pool.end(); ++it) {
+        it->join();
+    }
+    return status;
+}
+
+int runServer(const ServerOptions& options, std::istream& in, std::ostream& out)
+{
+    return serve(options, [&](const std::shared_ptr<RequestQueue>& queue, unsigned int) {
+        readRequests(std::make_shared<StreamConnection>(in, out), queue);
+        return 0;
+    });
+}
+
+int runServer(const ServerOptions& options)
+{
+    if (options.socketPath.empty()) {
+        std::ios::sync_with_stdio(false);
+        return runServer(options, std::cin, std::cout);
+    }
+#ifndef _WIN32
+    return serve(options, [&](const std::shared_ptr<RequestQueue>& queue, unsigned int threads) {
+        try {
+            // Writing to a client that has disconnected must not end the server
+            signal(SIGPIPE, SIG_IGN);
+            const int server = listenOnSocket(options.socketPath);
+            std::cerr << "Listening on " << options.socketPath << " with " << threads << " worker(s)" << std::endl;
+            for (;;) {
+                const int client = accept(server, nullptr, nullptr);
+                if (client < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) {
+                        continue;
+                    }
+                    throw std::runtime_error(std::string("Unable to accept connection: ") + strerror(errno));
+                }
+                // Reader keeps queue alive, after server stops it only finds queue closed
+                std::thread(readRequests, std::make_shared<SocketConnection>(client), queue).detach();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+        }
+        return 1;
+    });
+#else
+    std::cerr << "ERROR: Unix sockets are not supported on this platform, serve on stdin / stdout instead" << std::endl;
+    return 1;
+#endif
+}
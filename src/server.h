@@ -0,0 +1,94 @@
+//
+//  Ripe
+//
+//  Copyright 2017-present Amrayn Web Services
+//
+//  https://muflihun.com
+//  https://amrayn.com
+//  https://github.com/amrayn/ripe
+//
+//  Author: @abumusamq
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef RipeServer_h
+#define RipeServer_h
+
+#include <iosfwd>
+#include <string>
+
+#include "../include/Ripe.h"
+
+///
+/// \brief Keys and settings that are loaded once when server starts
+///
+struct ServerOptions {
+    ///
+    /// \brief AES key (hex) for encrypt and decrypt requests
+    ///
+    std::string key;
+    std::string aesMode;
+    std::string clientId;
+    std::string privateKeyPEM;
+    std::string secret;
+    std::string publicKeyPEM;
+    Ripe::SignatureScheme scheme;
+    Ripe::HashAlgorithm hashAlgorithm;
+    ///
+    /// \brief Number of worker threads, 0 for number of CPU cores
+    ///
+    unsigned int threads;
+    ///
+    /// \brief Unix socket to listen on, if empty requests are read from stdin and responses written to stdout
+    ///
+    std::string socketPath;
+
+    ServerOptions() :
+        aesMode("cbc"),
+        scheme(Ripe::SIGNATURE_RSA_PKCS1_SHA1),
+        hashAlgorithm(Ripe::HASH_SHA256),
+        threads(0)
+    {
+    }
+};
+
+///
+/// \brief Serves requests until end of stdin (or forever when listening on socket)
+///
+/// Every request is a header line <pre>[ID] [OPERATION] [SIZE]</pre> followed by SIZE bytes of data. Operations are
+/// encrypt, decrypt, sign, verify (data is <pre>[SIGNATURE]:[DATA]</pre>), hash, compress, decompress and
+/// stats (see statsToJson(), data is ignored).
+/// Requests are handled concurrently so responses (<pre>[ID] ok|error [SIZE]</pre> followed by SIZE bytes
+/// of result or error message) may come in different order than requests.
+///
+/// \return Exit code
+///
+int runServer(const ServerOptions& options);
+
+///
+/// \brief Serves requests read from in until it ends, responses are written to out. Header lines longer than
+/// 1024 bytes or invalid headers get an error response (with ID - if it cannot be parsed) and end the input
+///
+/// \return Exit code
+///
+int runServer(const ServerOptions& options, std::istream& in, std::ostream& out);
+
+///
+/// \brief Ripe::stats() as JSON: <pre>{"enabled":true,"operations":[{"name":"aes.encrypt","calls":1,"bytes":16,
+/// "totalNanoseconds":812,"maxNanoseconds":812,"histogram":[0,...,1]}]}</pre> where histogram[i] is number of calls that
+/// took [2^i, 2^(i+1)) nanoseconds (trailing empty buckets are omitted). Operations that were never called are omitted
+///
+std::string statsToJson();
+
+#endif /* RipeServer_h */
@@ -0,0 +1,116 @@
+#ifndef SERVER_TEST_H
+#define SERVER_TEST_H
+
+#include <sstream>
+
+#include "include/Ripe.h"
+#include "src/server.h"
+#include "test.h"
+
+static ServerOptions serverOptions()
+{
+    ServerOptions options;
+    // Single worker responds in order of requests
+    options.threads = 1;
+    options.key = "B1C8BFB9DA2D4FB054FE73047AE700BC";
+    return options;
+}
+
+static std::string serve(const std::string& requests, int* status = nullptr, const ServerOptions& options = serverOptions())
+{
+    std::istringstream in(requests);
+    std::ostringstream out;
+    const int result = runServer(options, in, out);
+    if (status != nullptr) {
+        *status = result;
+    }
+    return out.str();
+}
+
+static std::string response(const std::string& id, bool ok, const std::string& body)
+{
+    return id + (ok ? " ok " : " error ") + std::to_string(body.size()) + "\n" + body;
+}
+
+TEST(ServerTest, RequestFraming)
+{
+    int status = -1;
+    const std::string data = "line one\nline two\r\n";
+    const std::string output = serve("1 hash 3\nabc\n2 hash " + std::to_string(data.size()) + "\r\n" + data + "3 hash 0\n", &status);
+    ASSERT_EQ(0, status);
+    ASSERT_EQ(response("1", true, Ripe::sha256Hash("abc"))
+              + response("2", true, Ripe::sha256Hash(data))
+              + response("3", true, Ripe::sha256Hash("")), output);
+}
+
+TEST(ServerTest, Roundtrip)
+{
+    const std::string compressed = Ripe::compressString("quick brown fox");
+    ASSERT_EQ(response("a", true, compressed) + response("b", true, "quick brown fox"),
+              serve("a compress 15\nquick brown fox\nb decompress " + std::to_string(compressed.size()) + "\n" + compressed));
+
+    const std::string encrypted = serve("e encrypt 10\nplain text");
+    const std::string header = encrypted.substr(0, encrypted.find('\n') + 1);
+    ASSERT_EQ(0u, header.find("e ok "));
+    const std::string packet = encrypted.substr(header.size());
+    ASSERT_EQ(response("d", true, "plain text"), serve("d decrypt " + std::to_string(packet.size()) + "\n" + packet));
+}
+
+TEST(ServerTest, SignVerify)
+{
+    // Without keys sign and verify fail but server keeps serving
+    ASSERT_EQ(response("1", false, "Server was started without private key [in-private]")
+              + response("2", false, "Server was started without public key [in-public]"),
+              serve("1 sign 3\nabc2 verify 5\n00:ab"));
+
+    if (!Ripe::isSignatureSchemeSupported(Ripe::SIGNATURE_ED25519)) {
+        return;
+    }
+    const Ripe::KeyPair pair = Ripe::generateEd25519KeyPair();
+    ServerOptions options = serverOptions();
+    options.scheme = Ripe::SIGNATURE_ED25519;
+    options.privateKeyPEM = pair.privateKey;
+    options.publicKeyPEM = pair.publicKey;
+    options.threads = 2;
+    const std::string signature = Ripe::sign("abc", pair.privateKey, Ripe::SIGNATURE_ED25519);
+    const std::string verify = signature + ":abc";
+    const std::string tampered = signature + ":abd";
+    int status = -1;
+    const std::string output = serve("1 sign 3\nabc\n2 verify " + std::to_string(verify.size()) + "\n" + verify
+                                     + "3 verify " + std::to_string(tampered.size()) + "\n" + tampered, &status, options);
+    ASSERT_EQ(0, status);
+    // Two workers can respond in any order
+    ASSERT_NE(std::string::npos, output.find(response("1", true, signature)));
+    ASSERT_NE(std::string::npos, output.find(response("2", true, "OK")));
+    ASSERT_NE(std::string::npos, output.find(response("3", true, "FAIL")));
+
+    // Keys are loaded when server starts
+    options.publicKeyPEM = "invalid";
+    ASSERT_EQ("", serve("1 sign 3\nabc", &status, options));
+    ASSERT_EQ(1, status);
+}
+
+TEST(ServerTest, ErrorResponses)
+{
+    // Failing requests do not end the input
+    ASSERT_EQ(response("1", false, "Unknown operation [nothing]") + response("2", true, Ripe::sha256Hash("abc")),
+              serve("1 nothing 0\n2 hash 3\nabc"));
+    ASSERT_EQ(0u, serve("1 decompress 3\nabc").find("1 error "));
+
+    // Invalid headers end the input as it cannot be resynchronized
+    const std::string invalidHeader = "Invalid request header, expected [ID] [OPERATION] [SIZE] (maximum size is 67108864)";
+    ASSERT_EQ(response("-", false, invalidHeader), serve("\n\n \n2 hash 3\nabc"));
+    ASSERT_EQ(response("garbage", false, invalidHeader), serve("garbage\n2 hash 3\nabc"));
+    ASSERT_EQ(response("1", false, invalidHeader), serve("1 hash abc\n"));
+    ASSERT_EQ(response("1", false, invalidHeader), serve("1 hash 67108865\n"));
+
+    // Header longer than 1024 bytes is rejected before it is read completely
+    ASSERT_EQ(response("-", false, "Request header is too long"), serve("1 hash " + std::string(2048, '0') + "3\nabc"));
+    ASSERT_EQ(response("1", true, Ripe::sha256Hash("abc")), serve("1 hash " + std::string(1000, '0') + "3\nabc"));
+
+    // Truncated data is not handled
+    ASSERT_EQ("", serve("1 hash 10\nabc"));
+    ASSERT_EQ("", serve(""));
+}
+
+#endif // SERVER_TEST_H
@@ -1,5 +1,6 @@
 #include "test.h"
 #include "RipeTest.h"
+#include "ServerTest.h"
 
 INITIALIZE_EASYLOGGINGPP
 